@@ -1 +1,8 @@
-c++ -O3 -Wall -shared -std=c++11 -fPIC $(python3 -m pybind11 --includes) ./robusttre/robustTRE.cpp -o robust_tre$(python3-config --extension-suffix) -lppl -lgmp -lgmpxx
\ No newline at end of file
+c++ -O3 -Wall -shared -std=c++11 -pthread -fPIC $(python3 -m pybind11 --includes) ./robusttre/robustTRE.cpp -o robust_tre$(python3-config --extension-suffix) -lppl -lgmp -lgmpxx
+
+# Behavioural checks on fixed inputs, each exits with the number of failed checks
+for check in concatenation_regressions serialization_checks parser_checks planner_checks \
+             external_checks period_list_checks online_checks ingestion_checks \
+             sweep_checks closure_checks op_cache_checks; do
+    c++ -O2 -Wall -std=c++11 -pthread -Iinclude ./examples/$check.cpp -o $check -lgmpxx -lgmp && ./$check || exit 1
+done
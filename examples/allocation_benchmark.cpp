@@ -0,0 +1,135 @@
+/*
+ *  Counts heap allocations made by the zone_set operators.
+ *
+ *  Build from the repository root:
+ *      c++ -O2 -std=c++11 -Iinclude examples/allocation_benchmark.cpp -o allocation_benchmark -lgmpxx -lgmp
+ *
+ *  Every operator runs once to warm up the per-thread sweep lists, then
+ *  once more while counting calls to operator new and to the GMP allocator.
+ *  The remaining allocations are the growth of the result vectors, so the
+ *  count per input zone should be close to zero and the GMP count zero for
+ *  double and rational; mpq_class is listed for comparison.
+ */
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <functional>
+
+#include <gmpxx.h>
+
+#include "zone_set.hpp"
+#include "rational.hpp"
+
+static std::size_t heap_allocations = 0;
+static std::size_t gmp_allocations = 0;
+
+/* Every replaceable form goes through `counted_allocate` and `counted_free` */
+static void* counted_allocate(std::size_t size){
+    heap_allocations++;
+    if(void* p = std::malloc(size ? size : 1)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+static void counted_free(void* p) noexcept {
+    std::free(p);
+}
+
+void* operator new(std::size_t size){
+    return counted_allocate(size);
+}
+
+void* operator new[](std::size_t size){
+    return counted_allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    counted_free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    counted_free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    counted_free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    counted_free(p);
+}
+
+static void* gmp_allocate(std::size_t size){
+    gmp_allocations++;
+    return std::malloc(size);
+}
+
+static void* gmp_reallocate(void* p, std::size_t, std::size_t size){
+    gmp_allocations++;
+    return std::realloc(p, size);
+}
+
+static void gmp_free(void* p, std::size_t){
+    std::free(p);
+}
+
+template <class T>
+timedrel::zone_set<T> random_set(std::mt19937& gen, int n){
+    timedrel::zone_set<T> zs;
+    std::uniform_int_distribution<int> gap(1, 8), length(1, 12);
+    int t = 0;
+    for(int i = 0; i < n; i++){
+        t += gap(gen);
+        int e = t + length(gen);
+        zs.add_from_period(T(t) / T(4), T(e) / T(4));
+        t = e;
+    }
+    return zs;
+}
+
+template <class T>
+void run(const char* name, int n){
+
+    typedef timedrel::zone_set<T> zone_set_type;
+
+    std::mt19937 gen(1);
+    zone_set_type zs1 = random_set<T>(gen, n);
+    zone_set_type zs2 = random_set<T>(gen, n);
+    zone_set_type few = random_set<T>(gen, 8);
+    /* A distinct but equal operand: includes(zs1, zs1) returns before sweeping */
+    zone_set_type same = zs1;
+
+    std::vector< std::pair<std::string, std::function<void()>> > ops = {
+        {"filter",          [&]{ zone_set_type::filter(zs1); }},
+        {"includes",        [&]{ zone_set_type::includes(zs1, same); }},
+        {"intersection",    [&]{ zone_set_type::intersection(zs1, zs2); }},
+        {"concatenation",   [&]{ zone_set_type::concatenation(zs1, zs2); }},
+        {"set_union",       [&]{ zone_set_type::set_union(zs1, zs2); }},
+        {"set_difference",  [&]{ zone_set_type::set_difference(zs1, few); }},
+        {"diamond_meets",   [&]{ zone_set_type::diamond_meets(zs1, T(0), T(4)); }},
+        {"box_starts",      [&]{ zone_set_type::box_starts(few, T(0), T(4)); }},
+    };
+
+    for(const auto& op : ops){
+        op.second();
+        std::size_t heap = heap_allocations, gmp = gmp_allocations;
+        op.second();
+        heap = heap_allocations - heap;
+        gmp = gmp_allocations - gmp;
+        std::printf("%-10s %-16s %8zu heap %8.3f per zone %8zu gmp\n",
+            name, op.first.c_str(), heap, double(heap) / (2*n), gmp);
+    }
+}
+
+int main(int argc, char** argv){
+    mp_set_memory_functions(gmp_allocate, gmp_reallocate, gmp_free);
+
+    int n = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    run<double>("double", n);
+    run<timedrel::rational>("rational", n);
+    run<mpq_class>("mpq_class", n);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ *  Checks the interned union and transitive closure against the plain ones.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/closure_checks.cpp -o closure_checks -lgmpxx -lgmp
+ *      ./closure_checks
+ *
+ *  `transitive_closure` only extends the zones that are new to its
+ *  interning table. The reference below is the closure loop without a
+ *  table, which extends every zone of the last round. On seeded operands,
+ *  both closures and both unions must hold the same zones up to dominated
+ *  ones, i.e. each set `includes` the other. Equal zones must also hash
+ *  alike, -0.0 bounds included. The exit status is the number of failed
+ *  checks.
+ */
+#include <cstdio>
+#include <random>
+#include <string>
+#include <functional>
+
+#include "zone_set.hpp"
+#include "rational.hpp"
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const std::string& what){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-28s %s\n", ok ? "ok" : "FAIL", name.c_str(), what.c_str());
+}
+
+/* Short zones of every kind, sorted by bmin */
+template <class T>
+timedrel::zone_set<T> random_set(std::mt19937& gen, int n){
+    timedrel::zone_set<T> zs;
+    std::uniform_int_distribution<int> gap(0, 3), length(0, 6), kind(0, 4), strict(0, 1);
+    int t = 0;
+    for(int i = 0; i < n; i++){
+        t += gap(gen);
+        int e = t + length(gen);
+        switch(kind(gen)){
+            case 0:  zs.add_from_period(T(t), T(e + 1)); break;
+            case 1:  zs.add_from_period_rise_anchor(T(t), T(e)); break;
+            case 2:  zs.add_from_period_fall_anchor(T(t), T(e)); break;
+            case 3:  zs.add_from_period_both_anchor(T(t), T(e)); break;
+            default: zs.add({T(t), T(t + gap(gen)), T(t + 1), T(e + 2), T(0), T(length(gen) + 3)},
+                            {bool(strict(gen)), bool(strict(gen)), bool(strict(gen)), bool(strict(gen)), true, bool(strict(gen))});
+        }
+    }
+    zs.sort_by_bmin();
+    return zs;
+}
+
+/* The closure loop without interning */
+template <class T>
+timedrel::zone_set<T> plain_closure(const timedrel::zone_set<T>& zs){
+    typedef timedrel::zone_set<T> zone_set_type;
+    zone_set_type zplus = zs, zlast = zs;
+    zone_set_type znext = zone_set_type::concatenation(zlast, zs);
+    while(!zone_set_type::includes(zplus, znext)){
+        zlast = znext;
+        zplus = zone_set_type::set_union(zplus, znext);
+        znext = zone_set_type::concatenation(zlast, zs);
+    }
+    return zplus;
+}
+
+template <class T>
+bool same_zones(const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2){
+    return timedrel::zone_set<T>::includes(zs1, zs2) and timedrel::zone_set<T>::includes(zs2, zs1);
+}
+
+template <class T>
+void run(const char* type, unsigned seeds){
+
+    typedef timedrel::zone_set<T> zone_set_type;
+    typedef typename zone_set_type::zone_type zone_type;
+
+    for(unsigned seed = 1; seed <= seeds; seed++){
+        std::mt19937 gen(seed);
+        std::string name = std::string(type) + " seed " + std::to_string(seed);
+
+        zone_set_type zs1 = random_set<T>(gen, 10 + 3*seed), zs2 = random_set<T>(gen, 10 + 2*seed);
+
+        timedrel::zone_interner<zone_type> table;
+        report(same_zones(zone_set_type::set_union(zs1, zs2, table), zone_set_type::set_union(zs1, zs2)), name, "set_union");
+
+        // Short zones only, so that the closure stops
+        zone_set_type shortened = zone_set_type::duration_restriction(zs1, T(0), T(8));
+        table.clear();
+        zone_set_type closure = zone_set_type::transitive_closure(shortened, table);
+        report(same_zones(closure, plain_closure(shortened)), name,
+            "transitive_closure, " + std::to_string(table.stats().duplicates) + " duplicates");
+    }
+}
+
+int main(){
+
+    run<double>("double", 8);
+    run<timedrel::rational>("rational", 4);
+
+    typedef timedrel::zone<double> zone_type;
+    zone_type z1 = zone_type::make({0.0, 1, 0, 2, 0, 2}), z2 = zone_type::make({-0.0, 1, 0, 2, 0, 2});
+    report(z1 == z2 and std::hash<zone_type>()(z1) == std::hash<zone_type>()(z2), "signed zero", "same hash");
+
+    return failures;
+}
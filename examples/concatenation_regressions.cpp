@@ -0,0 +1,79 @@
+/*
+ *  Checks concatenation on hand-built pairs of zones that earlier versions
+ *  of the sweeps got wrong.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/concatenation_regressions.cpp -o concatenation_regressions -lgmpxx -lgmp
+ *      ./concatenation_regressions
+ *
+ *  Each case runs through concatenation, concatenation_parallel and
+ *  concatenation_duration_restriction, and the result must be exactly the
+ *  expected zones. The exit status is the number of failed checks.
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "zone_set.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef zone_set_type::zone_type          zone_type;
+typedef zone_type::lower_bound_type       lower_bound_type;
+typedef zone_type::upper_bound_type       upper_bound_type;
+
+/* Zone of b in [b1, b2], e in [e1, e2] and d in [0, 10], with the given strictness of the e and b ends */
+static zone_type box(double b1, bool b1_closed, double b2, double e1, double e2, bool e2_closed){
+    return zone_type::make(
+        lower_bound_type(b1, b1_closed), upper_bound_type(b2, true),
+        lower_bound_type(e1, true),      upper_bound_type(e2, e2_closed),
+        lower_bound_type::closed(0),     upper_bound_type::closed(10));
+}
+
+static zone_set_type set_of(const std::vector<zone_type>& zones){
+    zone_set_type zs;
+    for(const auto& z : zones){
+        zs.add(z);
+    }
+    return zs;
+}
+
+static int failures = 0;
+
+static void check(const std::string& name, const zone_set_type& zs1, const zone_set_type& zs2, const zone_set_type& expected){
+
+    const std::vector< std::pair<std::string, zone_set_type> > results = {
+        {"concatenation",          zone_set_type::concatenation(zs1, zs2)},
+        {"concatenation_parallel", zone_set_type::concatenation_parallel(zs1, zs2, 2)},
+        {"duration_restriction",   zone_set_type::concatenation_duration_restriction(zs1, zs2, -1.0, 100.0)},
+    };
+
+    for(const auto& r : results){
+        bool ok = r.second == expected;
+        failures += ok ? 0 : 1;
+        std::printf("%-4s %-28s %-24s %zu zones\n", ok ? "ok" : "FAIL", name.c_str(), r.first.c_str(), r.second.size());
+    }
+}
+
+int main(){
+
+    // Left ends in [2, 3] and right begins in (3, 4]: the periods cannot meet
+    check("open touch",
+        set_of({box(0, true, 1, 2, 3, true)}),
+        set_of({box(3, false, 4, 5, 6, true)}),
+        zone_set_type());
+
+    // Same with a closed begin: they meet at 3
+    check("closed touch",
+        set_of({box(0, true, 1, 2, 3, true)}),
+        set_of({box(3, true, 4, 5, 6, true)}),
+        set_of({zone_type::make({0, 1, 5, 6, 4, 6}, {1, 1, 1, 1, 1, 1})}));
+
+    // The right zone ends at 2, before the left one can end: once the right
+    // operand is used up, the left zone must not be paired with it
+    check("expired right zone",
+        set_of({box(0, true, 1, 3, 4, true)}),
+        set_of({box(1, true, 2, 5, 6, true)}),
+        zone_set_type());
+
+    return failures;
+}
@@ -0,0 +1,93 @@
+/*
+ *  Checks the out-of-core operators against the in-memory ones.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/external_checks.cpp -o external_checks -lgmpxx -lgmp
+ *      ./external_checks
+ *
+ *  The operands are generated from fixed seeds and written as segments of
+ *  1024 zones, the smallest buffer, so every operator reads and writes
+ *  several segments. Each result must be sorted (by bmin, or by emin when
+ *  asked) and hold the same zones as the in-memory operator; zones with an
+ *  equal key may come in another order, so the sets are compared with
+ *  `includes` both ways, after sorting by bmin. The segments are written
+ *  to the current directory and removed afterwards. The exit status is
+ *  the number of failed checks.
+ */
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "zone_set.hpp"
+#include "external.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef zone_set_type::zone_type          zone_type;
+
+static int failures = 0;
+
+/* Periods with every kind of anchor and zones with random strictness, sorted by bmin */
+static zone_set_type random_set(std::mt19937& gen, int n){
+    zone_set_type zs;
+    std::uniform_int_distribution<int> gap(0, 3), length(0, 6), kind(0, 4), strict(0, 1);
+    int t = 0;
+    for(int i = 0; i < n; i++){
+        t += gap(gen);
+        int e = t + length(gen);
+        switch(kind(gen)){
+            case 0:  zs.add_from_period(t, e + 1); break;
+            case 1:  zs.add_from_period_rise_anchor(t, e); break;
+            case 2:  zs.add_from_period_fall_anchor(t, e); break;
+            case 3:  zs.add_from_period_both_anchor(t, e); break;
+            default: zs.add({double(t), double(t + gap(gen)), double(t + 1), double(e + 2), 0, double(length(gen) + 3)},
+                            {bool(strict(gen)), bool(strict(gen)), bool(strict(gen)), bool(strict(gen)), true, bool(strict(gen))});
+        }
+    }
+    zs.sort_by_bmin();
+    return zs;
+}
+
+static void check(const std::string& name, const std::string& op,
+                  const std::vector<std::string>& paths, const zone_set_type& expected, bool by_emin = false){
+
+    zone_set_type result = timedrel::read_segments<double>(paths);
+    bool ok = by_emin ? result.is_sorted_by_emin() : result.is_sorted_by_bmin();
+    result.sort_by_bmin();
+    ok = ok and zone_set_type::includes(result, expected) and zone_set_type::includes(expected, result);
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-10s %-14s %6zu zones in %zu segments\n", ok ? "ok" : "FAIL",
+        name.c_str(), op.c_str(), result.size(), paths.size());
+    timedrel::remove_segments(paths);
+}
+
+int main(){
+
+    timedrel::external_options options;
+    options.prefix = "external_checks";
+    options.memory_budget = 1;
+
+    for(unsigned seed = 1; seed <= 3; seed++){
+
+        std::mt19937 gen(seed);
+        zone_set_type zs1 = random_set(gen, 4000 + 500*seed);
+        zone_set_type zs2 = random_set(gen, 3000);
+        std::string name = "seed " + std::to_string(seed);
+
+        std::vector<std::string> paths1 = timedrel::write_segments(zs1, options);
+        std::vector<std::string> paths2 = timedrel::write_segments(zs2, options);
+
+        check(name, "sort",          timedrel::external_sort<double>(paths1, options), zs1);
+        check(name, "sort by emin",  timedrel::external_sort<double>(paths1, options, true), zs1, true);
+        check(name, "filter",        timedrel::external_filter<double>(paths1, options), zone_set_type::filter(zs1));
+        check(name, "intersection",  timedrel::external_intersection<double>(paths1, paths2, options),
+                                     zone_set_type::intersection(zs1, zs2));
+        check(name, "concatenation", timedrel::external_concatenation<double>(paths1, paths2, options),
+                                     zone_set_type::concatenation(zs1, zs2));
+
+        timedrel::remove_segments(paths1);
+        timedrel::remove_segments(paths2);
+    }
+
+    return failures;
+}
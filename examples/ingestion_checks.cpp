@@ -0,0 +1,152 @@
+/*
+ *  Checks signal ingestion and period coalescing.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/ingestion_checks.cpp -o ingestion_checks -lgmpxx -lgmp
+ *      ./ingestion_checks
+ *
+ *  `ingest_signal` runs over blocks of byte masks; here it must give exactly
+ *  the zones of a sample-by-sample loop, on seeded signals that span several
+ *  blocks and hold long constant runs, for every comparison with and without
+ *  hysteresis. `ingest_signals` must agree with it on several threads, and
+ *  bad input must throw. `period_coalescer` is checked on the example of its
+ *  documentation and on its counters. The exit status is the number of
+ *  failed checks.
+ */
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "zone_set.hpp"
+#include "ingestion.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef zone_set_type::zone_type          zone_type;
+typedef timedrel::predicate<double>       predicate_type;
+
+using timedrel::comparison;
+using timedrel::period_anchor;
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const std::string& what){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-28s %s\n", ok ? "ok" : "FAIL", name.c_str(), what.c_str());
+}
+
+static bool holds(comparison op, double v, double threshold){
+    switch(op){
+        case comparison::gt:  return v >  threshold;
+        case comparison::geq: return v >= threshold;
+        case comparison::lt:  return v <  threshold;
+        default:              return v <= threshold;
+    }
+}
+
+/* One sample at a time, as `ingest_signal` documents it */
+static zone_set_type reference(const std::vector<double>& times, const std::vector<double>& values, const predicate_type& p){
+    zone_set_type result;
+    bool state = false;
+    std::size_t rise = 0;
+    for(std::size_t i = 0; i < times.size(); i++){
+        if(!state and holds(p.op, values[i], p.threshold)){
+            state = true;
+            rise = i;
+        } else if(state and !holds(p.op, values[i], p.stay_threshold())){
+            result.add(zone_type::make_from_period(times[rise], times[i], p.anchor));
+            state = false;
+        }
+    }
+    if(state){
+        result.add(zone_type::make_from_period(times[rise], times.back(), p.anchor));
+    }
+    return result;
+}
+
+static void check_ingestion(unsigned seed){
+
+    // Integer steps so that comparisons hit the threshold exactly; repeated times
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> step(-2, 2), hold(0, 3), dt(0, 4);
+    std::vector<double> times, values;
+    double t = 0, v = 0;
+    for(int i = 0; i < 10000; i++){
+        if(hold(gen) == 0){
+            v += step(gen);
+        }
+        t += dt(gen);
+        times.push_back(t / 4);
+        values.push_back(v);
+    }
+
+    const comparison ops[] = {comparison::gt, comparison::geq, comparison::lt, comparison::leq};
+    const char* op_names[] = {"gt", "geq", "lt", "leq"};
+
+    std::vector<predicate_type> predicates;
+    for(int k = 0; k < 4; k++){
+        for(double hysteresis : {0.0, 2.0}){
+            predicate_type p(0, ops[k], 0, hysteresis, k % 2 ? period_anchor::rise : period_anchor::none);
+            predicates.push_back(p);
+            zone_set_type zs = timedrel::ingest_signal(times.data(), values.data(), times.size(), p);
+            report(zs == reference(times, values, p), "seed " + std::to_string(seed),
+                std::string(op_names[k]) + (hysteresis != 0 ? " with hysteresis" : "") +
+                ", " + std::to_string(zs.size()) + " zones");
+        }
+    }
+
+    std::vector<zone_set_type> all = timedrel::ingest_signals(times.data(), {values.data()}, times.size(), predicates, 4);
+    bool same = all.size() == predicates.size();
+    for(std::size_t k = 0; same and k < all.size(); k++){
+        same = all[k] == timedrel::ingest_signal(times.data(), values.data(), times.size(), predicates[k]);
+    }
+    report(same, "seed " + std::to_string(seed), "ingest_signals on 4 threads");
+}
+
+static void check_rejected(const std::string& name, const std::vector<double>& times, const predicate_type& p){
+    std::vector<double> values(times.size(), 1.0);
+    bool thrown = false;
+    try {
+        timedrel::ingest_signal(times.data(), values.data(), times.size(), p);
+    } catch(const std::invalid_argument&){
+        thrown = true;
+    }
+    report(thrown, name, "rejected");
+}
+
+int main(){
+
+    for(unsigned seed = 1; seed <= 3; seed++){
+        check_ingestion(seed);
+    }
+
+    check_rejected("decreasing times", {0, 2, 1}, predicate_type(0, comparison::gt, 0));
+    check_rejected("negative hysteresis", {0, 1, 2}, predicate_type(0, comparison::gt, 0, -1));
+
+    // [0,10], [10,15] and [15.1,20] give [0,15] and [15.1,20]; [30,30] is empty
+    timedrel::period_coalescer<double> coalescer;
+    coalescer.add(15.1, 20);
+    coalescer.add(0, 10);
+    coalescer.add(30, 30);
+    coalescer.add(10, 15);
+    zone_set_type expected;
+    expected.add_from_period(0, 15);
+    expected.add_from_period(15.1, 20);
+    zone_set_type zs = coalescer.build();
+    report(zs == expected and zs.is_period_list(), "coalescer", std::to_string(zs.size()) + " zones");
+    report(coalescer.saved() == 1 and coalescer.dropped() == 1, "coalescer",
+        "saved " + std::to_string(coalescer.saved()) + ", dropped " + std::to_string(coalescer.dropped()));
+
+    timedrel::period_coalescer<double> tolerant(0.1);
+    tolerant.add(0, 10);
+    tolerant.add(10, 15);
+    tolerant.add(15.1, 20);
+    expected = zone_set_type();
+    expected.add_from_period(0, 20);
+    zs = tolerant.build();
+    report(zs == expected and tolerant.saved() == 2 and tolerant.dropped() == 0, "coalescer, gap tolerance 0.1",
+        std::to_string(zs.size()) + " zones");
+
+    return failures;
+}
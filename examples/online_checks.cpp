@@ -0,0 +1,131 @@
+/*
+ *  Checks the online monitor against the batch operators.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/online_checks.cpp -o online_checks -lgmpxx -lgmp
+ *      ./online_checks
+ *
+ *  Two atoms get the periods of seeded random signals in time order, with
+ *  the watermark advanced to each begin, and the zones emitted along the
+ *  way and by `finish` are collected. They must equal the batch operator on
+ *  the whole signals up to dominated zones, i.e. each set `includes` the
+ *  other. Every anchor combination is tried. The exit status is the number
+ *  of failed checks.
+ */
+#include <array>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+
+#include "zone_set.hpp"
+#include "online.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef zone_set_type::zone_type          zone_type;
+typedef timedrel::online_monitor<double>  monitor_type;
+typedef monitor_type::node_id             node_id;
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const std::string& op){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-28s %s\n", ok ? "ok" : "FAIL", name.c_str(), op.c_str());
+}
+
+/* Builds the monitor graph over atoms a and b */
+typedef std::function<node_id(monitor_type&, node_id, node_id)> online_op;
+/* The batch operator on the whole match sets */
+typedef std::function<zone_set_type(const zone_set_type&, const zone_set_type&)> batch_op;
+
+static void check(const std::string& name, const std::string& op, unsigned seed,
+                  timedrel::period_anchor anchor_a, timedrel::period_anchor anchor_b,
+                  const online_op& build, const batch_op& batch){
+
+    monitor_type monitor;
+    node_id a = monitor.atom(anchor_a), b = monitor.atom(anchor_b);
+    monitor.set_output(build(monitor, a, b));
+
+    // begin, end and atom of every period, in time order
+    std::mt19937 gen(seed);
+    std::vector< std::array<double, 3> > periods;
+    for(int k = 0; k < 2; k++){
+        double t = 0;
+        for(int i = 0; i < 40; i++){
+            t += gen() % 4;
+            double e = t + gen() % 5;
+            periods.push_back({t, e, double(k)});
+            t = e + gen() % 2;
+        }
+    }
+    std::sort(periods.begin(), periods.end());
+
+    zone_set_type zs_a, zs_b, result;
+    for(const auto& p : periods){
+        node_id id = p[2] == 0 ? a : b;
+        monitor.push_period(id, p[0], p[1]);
+        (id == a ? zs_a : zs_b).add(zone_type::make_from_period(p[0], p[1], id == a ? anchor_a : anchor_b));
+        zone_set_type out = monitor.advance(p[0]);
+        result.insert(result.end(), out.cbegin(), out.cend());
+    }
+    zone_set_type out = monitor.finish();
+    result.insert(result.end(), out.cbegin(), out.cend());
+
+    result.sort_by_bmin();
+    zs_a.sort_by_bmin();
+    zs_b.sort_by_bmin();
+    zone_set_type expected = batch(zs_a, zs_b);
+
+    report(zone_set_type::includes(result, expected) and zone_set_type::includes(expected, result), name, op);
+}
+
+int main(){
+
+    using timedrel::period_anchor;
+    const period_anchor anchors[] = {period_anchor::none, period_anchor::rise, period_anchor::fall, period_anchor::both};
+    const char* anchor_names[] = {"none", "rise", "fall", "both"};
+
+    const std::vector< std::pair<std::string, std::pair<online_op, batch_op> > > ops = {
+        {"intersection", {
+            [](monitor_type& m, node_id a, node_id b){return m.intersection(a, b);},
+            [](const zone_set_type& a, const zone_set_type& b){return zone_set_type::intersection(a, b);}}},
+        {"set_union", {
+            [](monitor_type& m, node_id a, node_id b){return m.set_union(a, b);},
+            [](const zone_set_type& a, const zone_set_type& b){return zone_set_type::set_union(a, b);}}},
+        {"concatenation", {
+            [](monitor_type& m, node_id a, node_id b){return m.concatenation(a, b);},
+            [](const zone_set_type& a, const zone_set_type& b){return zone_set_type::concatenation(a, b);}}},
+        {"duration of concatenation", {
+            [](monitor_type& m, node_id a, node_id b){return m.duration_restriction(m.concatenation(a, b), 2.0, 6.0);},
+            [](const zone_set_type& a, const zone_set_type& b){
+                return zone_set_type::duration_restriction(zone_set_type::concatenation(a, b), 2.0, 6.0);}}},
+    };
+
+    unsigned seed = 0;
+    for(int i = 0; i < 4; i++){
+        for(int j = 0; j < 4; j++){
+            std::string name = std::string(anchor_names[i]) + " / " + anchor_names[j];
+            for(const auto& op : ops){
+                check(name, op.first, ++seed, anchors[i], anchors[j], op.second.first, op.second.second);
+            }
+        }
+    }
+
+    // Periods behind the watermark are rejected
+    monitor_type monitor;
+    node_id a = monitor.atom();
+    monitor.set_output(a);
+    monitor.advance(5);
+    bool thrown = false;
+    try {
+        monitor.push_period(a, 4, 6);
+    } catch(const std::invalid_argument&){
+        thrown = true;
+    }
+    report(thrown, "late period", "rejected");
+
+    return failures;
+}
@@ -0,0 +1,113 @@
+/*
+ *  Checks the operator cache: hits, misses, eviction and collisions.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/op_cache_checks.cpp -o op_cache_checks -lgmpxx -lgmp
+ *      ./op_cache_checks
+ *
+ *  Results from the cache must equal the operator, and the counts must
+ *  match the calls made. A set whose fingerprint is forged to that of
+ *  another set must get its own result, counted as a collision. The exit
+ *  status is the number of failed checks.
+ */
+#include <cstdio>
+#include <string>
+#include <cstdint>
+
+#include "zone_set.hpp"
+#include "op_cache.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef timedrel::operator_cache<double>  cache_type;
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const timedrel::operator_cache_stats& s){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-28s hits %zu misses %zu collisions %zu evictions %zu entries %zu\n", ok ? "ok" : "FAIL",
+        name.c_str(), s.hits, s.misses, s.collisions, s.evictions, s.entries);
+}
+
+/* A zone set whose cached fingerprint can be overwritten */
+struct forged_set : zone_set_type {
+    void forge_fingerprint(std::uint64_t h){
+        fingerprint_cache.store(h);
+    }
+};
+
+static zone_set_type concatenation(cache_type& cache, const zone_set_type& zs1, const zone_set_type& zs2, int& calls){
+    return cache.apply("concatenation", {&zs1, &zs2}, {}, [&]{
+        calls++;
+        return zone_set_type::concatenation(zs1, zs2);
+    });
+}
+
+static zone_set_type diamond_meets(cache_type& cache, const zone_set_type& zs, double a, double b, int& calls){
+    return cache.apply("diamond_meets", {&zs}, {a, b}, [&]{
+        calls++;
+        return zone_set_type::diamond_meets(zs, a, b);
+    });
+}
+
+int main(){
+
+    zone_set_type zs1, zs2;
+    for(int i = 0; i < 50; i++){
+        zs1.add_from_period(3*i, 3*i + 2);
+        zs2.add_from_period_rise_anchor(3*i + 1, 3*i + 4);
+    }
+    const zone_set_type expected = zone_set_type::concatenation(zs1, zs2);
+
+    cache_type cache(2);
+    int calls = 0;
+
+    // The second call and a call on equal copies hit; swapped operands miss
+    zone_set_type copy1 = zs1, copy2 = zs2;
+    bool ok = concatenation(cache, zs1, zs2, calls) == expected and
+              concatenation(cache, zs1, zs2, calls) == expected and
+              concatenation(cache, copy1, copy2, calls) == expected;
+    concatenation(cache, zs2, zs1, calls);
+    timedrel::operator_cache_stats s = cache.stats();
+    report(ok and calls == 2 and s.hits == 2 and s.misses == 2, "same operands", s);
+
+    // Parameters are part of the key; the least recently used entry goes first
+    ok = diamond_meets(cache, zs1, 0, 4, calls) == zone_set_type::diamond_meets(zs1, 0.0, 4.0) and
+         diamond_meets(cache, zs1, 1, 4, calls) == zone_set_type::diamond_meets(zs1, 1.0, 4.0);
+    s = cache.stats();
+    report(ok and calls == 4 and s.evictions == 2 and s.entries == 2, "parameters and eviction", s);
+
+    // A forged fingerprint finds the entry of zs1 but must not get its result
+    cache.clear();
+    calls = 0;
+    forged_set other;
+    other.add_from_period(100, 101);
+    other.forge_fingerprint(zs1.fingerprint());
+    diamond_meets(cache, zs1, 0, 4, calls);
+    bool correct = diamond_meets(cache, other, 0, 4, calls) == zone_set_type::diamond_meets(other, 0.0, 4.0);
+    s = cache.stats();
+    report(correct and calls == 2 and s.collisions == 0 and s.misses == 2, "different sizes", s);
+
+    // Same size, so the keys are equal and only the stored operands tell them apart
+    cache.clear();
+    calls = 0;
+    forged_set twin;
+    for(int i = 0; i < 50; i++){
+        twin.add_from_period(3*i + 1000, 3*i + 1002);
+    }
+    twin.forge_fingerprint(zs1.fingerprint());
+    diamond_meets(cache, zs1, 0, 4, calls);
+    correct = diamond_meets(cache, twin, 0, 4, calls) == zone_set_type::diamond_meets(twin, 0.0, 4.0) and
+              diamond_meets(cache, zs1, 0, 4, calls) == zone_set_type::diamond_meets(zs1, 0.0, 4.0);
+    s = cache.stats();
+    report(correct and calls == 2 and s.collisions == 1 and s.hits == 1, "forged fingerprint", s);
+
+    // Capacity 0 computes every time and keeps nothing
+    cache.set_capacity(0);
+    calls = 0;
+    concatenation(cache, zs1, zs2, calls);
+    concatenation(cache, zs1, zs2, calls);
+    s = cache.stats();
+    report(calls == 2 and s.entries == 0, "disabled", s);
+
+    return failures;
+}
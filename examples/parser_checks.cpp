@@ -0,0 +1,94 @@
+/*
+ *  Checks the TRE parser: compiled expressions against the zone_set
+ *  operators they stand for, and rejected expressions.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/parser_checks.cpp -o parser_checks -lgmpxx -lgmp
+ *      ./parser_checks
+ *
+ *  Each valid expression is compiled and evaluated on two fixed match sets
+ *  and must give exactly the zones of the same operators applied by hand.
+ *  Each invalid one must throw std::invalid_argument. The exit status is
+ *  the number of failed checks.
+ */
+#include <map>
+#include <cstdio>
+#include <string>
+#include <stdexcept>
+
+#include "zone_set.hpp"
+#include "tre_parser.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef zone_set_type::zone_type          zone_type;
+typedef zone_type::lower_bound_type       lower_bound_type;
+typedef zone_type::upper_bound_type       upper_bound_type;
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& text, const std::string& what){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-36s %s\n", ok ? "ok" : "FAIL", text.c_str(), what.c_str());
+}
+
+static void check(const std::string& text, const std::map<std::string, zone_set_type>& atoms, const zone_set_type& expected){
+    try {
+        zone_set_type result = timedrel::compile<double>(text).evaluate(atoms);
+        report(result == expected, text, std::to_string(result.size()) + " zones");
+    } catch(const std::exception& e){
+        report(false, text, e.what());
+    }
+}
+
+static void check_rejected(const std::string& text){
+    try {
+        timedrel::compile<double>(text);
+        report(false, text, "accepted");
+    } catch(const std::invalid_argument& e){
+        report(true, text, e.what());
+    }
+}
+
+int main(){
+
+    zone_set_type p, q;
+    for(int i = 0; i < 6; i++){
+        p.add_from_period(4*i, 4*i + 2);
+        q.add_from_period(4*i + 1, 4*i + 4);
+    }
+    const std::map<std::string, zone_set_type> atoms = {{"p", p}, {"q", q}};
+
+    const lower_bound_type one = lower_bound_type::closed(1);
+    const upper_bound_type three = upper_bound_type::closed(3);
+
+    check("p",                      atoms, p);
+    check("p | q",                  atoms, zone_set_type::set_union(p, q));
+    check("p & q",                  atoms, zone_set_type::intersection(p, q));
+    check("p ; q",                  atoms, zone_set_type::concatenation(p, q));
+    check("!p",                     atoms, zone_set_type::complementation(p));
+    check("p+",                     atoms, zone_set_type::transitive_closure(p));
+    check("p % [1,3]",              atoms, zone_set_type::duration_restriction(p, one, three));
+    check("<p>_(1,3]",              atoms, zone_set_type::duration_restriction(p, 1.0, 3.0));
+    check("(p ; q) % [1,3]",        atoms,
+        zone_set_type::duration_restriction(zone_set_type::concatenation(p, q), one, three));
+    check("diamond_meets[1,3](q)",  atoms, zone_set_type::diamond_meets(q, one, three));
+    check("box_started_by[0,inf)(p)", atoms,
+        zone_set_type::box_started_by(p, lower_bound_type::closed(0), upper_bound_type::unbounded()));
+
+    // Binding: '|' is loosest, then '&', then ';'
+    check("p | q & p ; q",          atoms,
+        zone_set_type::set_union(p, zone_set_type::intersection(q, zone_set_type::concatenation(p, q))));
+
+    check_rejected("p*");
+    check_rejected("(p ; q)*");
+    check_rejected("p+*");
+    check_rejected("p ;");
+    check_rejected("(p");
+    check_rejected("p )");
+    check_rejected("p % [1,3");
+    check_rejected("p % [a,3]");
+    check_rejected("diamond_meets[1,3] p");
+    check_rejected("");
+
+    return failures;
+}
@@ -0,0 +1,99 @@
+/*
+ *  Checks the period-list fast paths of the boolean operators against the
+ *  zone sweeps.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/period_list_checks.cpp -o period_list_checks -lgmpxx -lgmp
+ *      ./period_list_checks
+ *
+ *  The operands are periods of seeded random signals, so `is_period_list`
+ *  holds and the operators take the interval merges. Repeating the first
+ *  period of one operand keeps its points but makes it an ordinary zone
+ *  set, which sends the same operator through the sweep. Both results must
+ *  denote the same periods, compared with `set_difference` both ways, and
+ *  the fast result must again be a period list. The exit status is the
+ *  number of failed checks.
+ */
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "zone_set.hpp"
+#include "rational.hpp"
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const std::string& op){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-20s %s\n", ok ? "ok" : "FAIL", name.c_str(), op.c_str());
+}
+
+/* Periods of a signal that switches at random quarter ticks */
+template <class T>
+timedrel::zone_set<T> random_signal(std::mt19937& gen, int n){
+    timedrel::zone_set<T> zs;
+    std::uniform_int_distribution<int> gap(1, 8), length(1, 12);
+    int t = 0;
+    for(int i = 0; i < n; i++){
+        t += gap(gen);
+        int e = t + length(gen);
+        zs.add_from_period(T(t) / T(4), T(e) / T(4));
+        t = e;
+    }
+    return zs;
+}
+
+/* The same periods with the first one repeated, which is no period list */
+template <class T>
+timedrel::zone_set<T> repeated(const timedrel::zone_set<T>& zs){
+    timedrel::zone_set<T> result = zs;
+    result.insert(result.begin(), zs.front());
+    return result;
+}
+
+template <class T>
+bool same_periods(const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2){
+    return timedrel::zone_set<T>::set_difference(zs1, zs2).empty() and
+           timedrel::zone_set<T>::set_difference(zs2, zs1).empty();
+}
+
+template <class T>
+void run(const char* type){
+
+    typedef timedrel::zone_set<T> zone_set_type;
+
+    for(unsigned seed = 1; seed <= 3; seed++){
+
+        std::mt19937 gen(seed);
+        zone_set_type p = random_signal<T>(gen, 200);
+        zone_set_type q = random_signal<T>(gen, 200);
+        zone_set_type slow_p = repeated(p);
+        std::string name = std::string(type) + " seed " + std::to_string(seed);
+
+        report(p.is_period_list() and q.is_period_list() and !slow_p.is_period_list(), name, "operands");
+
+        zone_set_type fast = zone_set_type::intersection(p, q);
+        report(fast.is_period_list() and same_periods(fast, zone_set_type::intersection(slow_p, q)), name, "intersection");
+
+        fast = zone_set_type::set_union(p, q);
+        report(fast.is_period_list() and same_periods(fast, zone_set_type::set_union(slow_p, q)), name, "set_union");
+
+        fast = zone_set_type::filter(p);
+        report(fast.is_period_list() and same_periods(fast, zone_set_type::filter(slow_p)), name, "filter");
+
+        zone_set_type both = zone_set_type::intersection(p, q);
+        zone_set_type either = zone_set_type::set_union(p, q);
+        zone_set_type slow_either = repeated(either);
+        report(zone_set_type::includes(either, p) == zone_set_type::includes(slow_either, p) and
+               zone_set_type::includes(p, either) == zone_set_type::includes(slow_p, either) and
+               zone_set_type::includes(p, both) == zone_set_type::includes(slow_p, both) and
+               zone_set_type::includes(either, p) and !zone_set_type::includes(p, either) and
+               zone_set_type::includes(p, both), name, "includes");
+    }
+}
+
+int main(){
+    run<double>("double");
+    run<timedrel::rational>("rational");
+    return failures;
+}
@@ -0,0 +1,71 @@
+/*
+ *  Checks that the plan optimizer keeps the meaning of a plan.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/planner_checks.cpp -o planner_checks -lgmpxx -lgmp
+ *      ./planner_checks
+ *
+ *  Each expression is compiled, optimized for three fixed match sets of
+ *  different sizes, and both plans are evaluated. The optimizer may split
+ *  the result into other zones, so the two results are compared as sets of
+ *  periods: each difference must be empty. The exit status is the number
+ *  of failed checks.
+ */
+#include <map>
+#include <cstdio>
+#include <string>
+
+#include "zone_set.hpp"
+#include "plan.hpp"
+#include "planner.hpp"
+#include "tre_parser.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef timedrel::plan<double>            plan_type;
+
+static int failures = 0;
+
+static void check(const std::string& text, const plan_type::atom_map& atoms){
+
+    plan_type p = timedrel::compile<double>(text);
+    plan_type optimized = timedrel::optimize(p, atoms);
+
+    zone_set_type expected = p.evaluate(atoms);
+    zone_set_type result = optimized.evaluate(atoms);
+
+    bool ok = zone_set_type::set_difference(expected, result).empty() and
+              zone_set_type::set_difference(result, expected).empty();
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-40s %3zu nodes %3zu zones, optimized %3zu nodes %3zu zones\n", ok ? "ok" : "FAIL",
+        text.c_str(), p.size(), expected.size(), optimized.size(), result.size());
+}
+
+int main(){
+
+    // p is dense, q sparser and r has a few long periods
+    zone_set_type p, q, r;
+    for(int i = 0; i < 24; i++){
+        p.add_from_period(2*i, 2*i + 1.5);
+    }
+    for(int i = 0; i < 8; i++){
+        q.add_from_period(6*i + 1, 6*i + 4);
+    }
+    for(int i = 0; i < 3; i++){
+        r.add_from_period(16*i, 16*i + 9);
+    }
+    const plan_type::atom_map atoms = {{"p", &p}, {"q", &q}, {"r", &r}};
+
+    check("p & q & r",                           atoms);
+    check("r & (q & p)",                         atoms);
+    check("p | q | r",                           atoms);
+    check("(p | q) % [1,3]",                     atoms);
+    check("(p & r) % [0,1]",                     atoms);
+    check("(p ; q & r) % [0,6]",                 atoms);
+    check("((p ; q) % [0,8]) % (2,5]",           atoms);
+    check("(p ; q) % [1,5] & r",                 atoms);
+    check("(p | q | r) % [1,2] & (q ; r)",       atoms);
+    check("diamond_meets[0,2](p | q) & r",       atoms);
+    check("!(p & q) & r % [0,4]",                atoms);
+
+    return failures;
+}
@@ -0,0 +1,109 @@
+/*
+ *  Checks the binary zone_set files: round trips and rejected headers.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/serialization_checks.cpp -o serialization_checks -lgmpxx -lgmp
+ *      ./serialization_checks
+ *
+ *  Every set is saved and loaded back with buffered reads and with mmap;
+ *  the loaded set must equal the saved one and keep its block index. Then
+ *  single header fields are overwritten and both loaders must throw. The
+ *  exit status is the number of failed checks.
+ */
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "zone_set.hpp"
+#include "serialization.hpp"
+
+typedef timedrel::zone_set<double>        zone_set_type;
+typedef zone_set_type::zone_type          zone_type;
+
+static const char* path = "serialization_checks.rtzs";
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const std::string& what){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-28s %s\n", ok ? "ok" : "FAIL", name.c_str(), what.c_str());
+}
+
+/* Sorted periods, with every other zone open on its end bounds */
+static zone_set_type sorted_set(int n){
+    zone_set_type zs;
+    for(int i = 0; i < n; i++){
+        bool closed = (i % 2) == 0;
+        zs.add(zone_type::make({double(i), double(i) + 1, double(i) + 2, double(i) + 4, 1, 4},
+                               {true, true, closed, closed, true, true}));
+    }
+    return zs;
+}
+
+static void check_round_trip(const std::string& name, const zone_set_type& zs, bool indexed){
+
+    timedrel::save(zs, path, 16);
+
+    for(int use_mmap = 0; use_mmap < 2; use_mmap++){
+        zone_set_type loaded = timedrel::load<double>(path, use_mmap != 0);
+        std::string mode = use_mmap ? "mmap" : "read";
+        report(loaded == zs, name, mode + " equal");
+        report((loaded.get_block_index() != nullptr) == indexed, name, mode + " block index");
+    }
+
+    timedrel::mapped_zone_set<double> mapped(path);
+    bool same = mapped.size() == zs.size();
+    for(std::size_t i = 0; same and i < zs.size(); i++){
+        same = mapped[i] == zs.cbegin()[i];
+    }
+    report(same, name, "mapped zones");
+}
+
+/* Overwrites `size` bytes of the header at `offset` */
+static void patch(std::size_t offset, std::uint64_t value, std::size_t size){
+    std::FILE* f = std::fopen(path, "r+b");
+    std::fseek(f, long(offset), SEEK_SET);
+    std::fwrite(&value, size, 1, f);
+    std::fclose(f);
+}
+
+static void check_rejected(const std::string& name, std::size_t offset, std::uint64_t value, std::size_t size){
+
+    timedrel::save(sorted_set(100), path, 16);
+    patch(offset, value, size);
+
+    for(int use_mmap = 0; use_mmap < 2; use_mmap++){
+        bool thrown = false;
+        try {
+            timedrel::load<double>(path, use_mmap != 0);
+        } catch(const std::runtime_error&){
+            thrown = true;
+        }
+        report(thrown, name, use_mmap ? "mmap rejected" : "read rejected");
+    }
+}
+
+int main(){
+
+    check_round_trip("empty", zone_set_type(), false);
+    check_round_trip("sorted", sorted_set(100), true);
+
+    zone_set_type unsorted = sorted_set(10);
+    unsorted.add_from_period(0, 1);
+    check_round_trip("unsorted", unsorted, false);
+
+    // Field offsets follow `zone_set_file_header`
+    check_rejected("bad magic",          0,  0x58585858, 4);
+    check_rejected("bad version",        4,  2, 2);
+    check_rejected("bad byte order",     6,  0x0201, 2);
+    check_rejected("bad value size",     9,  4, 1);
+    check_rejected("count past the end", 16, (std::uint64_t(1) << 61) + 1, 8);
+    check_rejected("misaligned values",  24, 65, 8);
+    check_rejected("signs past the end", 32, ~std::uint64_t(0), 8);
+    check_rejected("index past the end", 48, std::uint64_t(1) << 59, 8);
+
+    std::remove(path);
+    return failures;
+}
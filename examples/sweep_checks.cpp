@@ -0,0 +1,141 @@
+/*
+ *  Checks intersection and concatenation against every pair of zones.
+ *
+ *  build.sh builds and runs it; by hand, from the repository root:
+ *      c++ -O2 -std=c++11 -pthread -Iinclude examples/sweep_checks.cpp -o sweep_checks -lgmpxx -lgmp
+ *      ./sweep_checks
+ *
+ *  The reference combines all pairs of zones, keeps the nonempty results
+ *  (for concatenation, of the pairs that meet) and filters them. The
+ *  operands are seeded and shaped to send the operators down each of their
+ *  paths: short zones only, short zones with a few zones long enough to be
+ *  queried through the long zone index, and densely overlapping zones that
+ *  intersect through the block summary tree. Results must equal the reference
+ *  up to dominated zones, i.e. each set `includes` the other. The exit
+ *  status is the number of failed checks.
+ */
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "zone_set.hpp"
+#include "rational.hpp"
+
+static int failures = 0;
+
+static void report(bool ok, const std::string& name, const std::string& op){
+    failures += ok ? 0 : 1;
+    std::printf("%-4s %-28s %s\n", ok ? "ok" : "FAIL", name.c_str(), op.c_str());
+}
+
+/* Short zones of every kind, plus `long_count` zones spanning hundreds of them */
+template <class T>
+timedrel::zone_set<T> random_set(std::mt19937& gen, int n, int long_count){
+    timedrel::zone_set<T> zs;
+    std::uniform_int_distribution<int> gap(0, 3), length(0, 6), kind(0, 4), strict(0, 1), place(0, 2*n);
+    int t = 0;
+    for(int i = 0; i < n; i++){
+        t += gap(gen);
+        int e = t + length(gen);
+        switch(kind(gen)){
+            case 0:  zs.add_from_period(T(t), T(e + 1)); break;
+            case 1:  zs.add_from_period_rise_anchor(T(t), T(e)); break;
+            case 2:  zs.add_from_period_fall_anchor(T(t), T(e)); break;
+            case 3:  zs.add_from_period_both_anchor(T(t), T(e)); break;
+            default: zs.add({T(t), T(t + gap(gen)), T(t + 1), T(e + 2), T(0), T(length(gen) + 3)},
+                            {bool(strict(gen)), bool(strict(gen)), bool(strict(gen)), bool(strict(gen)), true, bool(strict(gen))});
+        }
+    }
+    for(int i = 0; i < long_count; i++){
+        int b = place(gen), l = 200 + place(gen) % 400;
+        zs.add({T(b), T(b + l), T(b + 3), T(b + l + 50), T(1), T(60)},
+               {bool(strict(gen)), bool(strict(gen)), true, true, true, bool(strict(gen))});
+    }
+    zs.sort_by_bmin();
+    return zs;
+}
+
+/* Periods [i + offset, i + l] anchored on their fall: begins overlap densely, ends meet only at i + l */
+template <class T>
+timedrel::zone_set<T> overlapping_set(int n, int l, const T& offset){
+    timedrel::zone_set<T> zs;
+    for(int i = 0; i < n; i++){
+        zs.add_from_period_fall_anchor(T(i) + offset, T(i + l));
+    }
+    return zs;
+}
+
+template <class T>
+timedrel::zone_set<T> all_pairs(const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2, bool concatenate){
+    typedef timedrel::zone_set<T> zone_set_type;
+    typedef typename zone_set_type::zone_type zone_type;
+    zone_set_type result;
+    for(auto it1 = zs1.cbegin(); it1 != zs1.cend(); it1++){
+        for(auto it2 = zs2.cbegin(); it2 != zs2.cend(); it2++){
+            if(!concatenate){
+                result.add(zone_type::intersection(*it1, *it2));
+            } else if(zone_type::meets(*it1, *it2)){
+                result.add(zone_type::concatenation(*it1, *it2));
+            }
+        }
+    }
+    result.sort_by_bmin();
+    return zone_set_type::filter(result);
+}
+
+template <class T>
+bool same_zones(const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2){
+    return timedrel::zone_set<T>::includes(zs1, zs2) and timedrel::zone_set<T>::includes(zs2, zs1);
+}
+
+template <class T>
+void check_intersection(const std::string& name, const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2){
+
+    typedef timedrel::zone_set<T> zone_set_type;
+
+    zone_set_type expected = all_pairs(zs1, zs2, false);
+    report(same_zones(zone_set_type::intersection(zs1, zs2), expected), name, "intersection");
+    report(same_zones(zone_set_type::intersection(zs2, zs1), expected), name, "intersection, swapped");
+    report(same_zones(zone_set_type::intersection_parallel(zs1, zs2, 4), expected), name, "intersection_parallel");
+}
+
+template <class T>
+void check(const std::string& name, const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2){
+
+    typedef timedrel::zone_set<T> zone_set_type;
+
+    check_intersection(name, zs1, zs2);
+
+    zone_set_type expected = all_pairs(zs1, zs2, true);
+    report(same_zones(zone_set_type::concatenation(zs1, zs2), expected), name, "concatenation");
+    report(same_zones(zone_set_type::concatenation_parallel(zs1, zs2, 4), expected), name, "concatenation_parallel");
+
+    expected = all_pairs(zs2, zs1, true);
+    report(same_zones(zone_set_type::concatenation(zs2, zs1), expected), name, "concatenation, swapped");
+}
+
+template <class T>
+void run(const char* type){
+
+    typedef timedrel::zone_set<T> zone_set_type;
+
+    for(unsigned seed = 1; seed <= 2; seed++){
+        std::mt19937 gen(seed);
+        std::string name = std::string(type) + " seed " + std::to_string(seed);
+
+        zone_set_type zs1 = random_set<T>(gen, 600, 0), zs2 = random_set<T>(gen, 400, 0);
+        check(name + ", short", zs1, zs2);
+
+        zs1 = random_set<T>(gen, 600, 8);
+        zs2 = random_set<T>(gen, 400, 5);
+        check(name + ", long", zs1, zs2);
+    }
+
+    check_intersection(std::string(type) + ", dense", overlapping_set<T>(400, 60, T(0)), overlapping_set<T>(400, 60, T(1) / T(2)));
+}
+
+int main(){
+    run<double>("double");
+    run<timedrel::rational>("rational");
+    return failures;
+}
@@ -0,0 +1,223 @@
+#ifndef TIMEDREL_BATCH_HPP
+#define TIMEDREL_BATCH_HPP 1
+
+#include <map>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+
+#include "parallel.hpp"
+#include "zone.hpp"
+#include "zone_set.hpp"
+#include "ingestion.hpp"
+#include "plan.hpp"
+
+namespace timedrel {
+
+/**
+ *  @brief  Largest shift that keeps some period of a zone inside it both ways
+ *  @param  z  A nonempty %zone
+ *  @return The largest r such that (b - r, e - r) and (b + r, e + r) are in
+ *          `z` for some (b, e) in `z`, ignoring strictness
+ *
+ *  For a fixed duration d the begin ranges over
+ *  [max(bmin, emin - d), min(bmax, emax - d)] and r(d) is half its length;
+ *  r(d) is concave and peaks at d = (emax - bmax + emin - bmin) / 2, clamped
+ *  to [dmin, dmax].
+ */
+template <class T>
+T translation_robustness(const zone<T>& z){
+
+    T bmin = z.get_bmin().value, bmax = z.get_bmax().value;
+    T emin = z.get_emin().value, emax = z.get_emax().value;
+
+    T d = (emax - bmax + emin - bmin) / 2;
+    d = std::max<T>(z.get_dmin().value, std::min<T>(z.get_dmax().value, d));
+
+    T width = std::min<T>(std::min<T>(bmax - bmin, emax - emin),
+                          std::min<T>(bmax - emin + d, emax - bmin - d));
+    return std::max<T>(T(0), width / 2);
+}
+
+/*
+ *  Per-trace figures of a batch evaluation.
+ */
+template <class T>
+struct trace_summary {
+
+    /* Number of zones in the result */
+    std::size_t zones = 0;
+
+    /* Smallest bmin and largest emax of the result (0 when nothing matched) */
+    T first_begin = T(0);
+    T last_end = T(0);
+
+    /* Largest `translation_robustness` over the result zones, 0 when nothing matched */
+    T robustness = T(0);
+
+    bool matched() const {
+        return zones > 0;
+    }
+
+    static trace_summary of(const zone_set<T>& zs){
+        trace_summary s;
+        s.zones = zs.size();
+        bool first = true;
+        for(const auto& z : zs){
+            T r = translation_robustness(z);
+            if(first){
+                s.first_begin = z.get_bmin().value;
+                s.last_end = z.get_emax().value;
+                s.robustness = r;
+                first = false;
+            } else {
+                s.first_begin = std::min<T>(s.first_begin, z.get_bmin().value);
+                s.last_end = std::max<T>(s.last_end, z.get_emax().value);
+                s.robustness = std::max<T>(s.robustness, r);
+            }
+        }
+        return s;
+    }
+};
+
+template <class T>
+struct batch_result {
+    /* One result per trace, empty when matches are not kept */
+    std::vector< zone_set<T> > matches;
+    std::vector< trace_summary<T> > summaries;
+};
+
+/*
+ *  Raw signals of one trace: `signals[k][i]` is the value of signal k at `times[i]`.
+ */
+template <class T>
+struct signal_trace {
+    const T* times;
+    std::vector<const T*> signals;
+    std::size_t samples;
+};
+
+namespace detail {
+
+/*
+ *  Runs `evaluate_trace(i, values)` for every trace on `num_threads` workers
+ *  that pick traces one at a time, so that long traces do not hold up a
+ *  static share. `values` is a worker-owned vector reused across traces.
+ */
+template <class T, class Function>
+batch_result<T> run_batch(const plan<T>& p, std::size_t traces, unsigned num_threads, bool keep_matches, Function evaluate_trace){
+
+    if(p.outputs().size() != 1){
+        throw std::logic_error("evaluate_batch: the plan must have exactly one output");
+    }
+    if(num_threads == 0){
+        num_threads = hardware_threads();
+    }
+
+    batch_result<T> result;
+    if(keep_matches){
+        result.matches.resize(traces);
+    }
+    result.summaries.resize(traces);
+
+    const std::vector<bool> needed = p.reachable();
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::exception_ptr> errors(num_threads);
+
+    parallel_for(num_threads, num_threads, [&](std::size_t, std::size_t, unsigned worker){
+        std::vector< zone_set<T> > values(p.size());
+        try {
+            for(std::size_t i = next++; i < traces and !failed; i = next++){
+                evaluate_trace(i, needed, values);
+                zone_set<T>& out = values[p.outputs().front()];
+                result.summaries[i] = trace_summary<T>::of(out);
+                if(keep_matches){
+                    result.matches[i] = std::move(out);
+                }
+            }
+        } catch(...) {
+            errors[worker] = std::current_exception();
+            failed = true;
+        }
+    });
+
+    for(const auto& e : errors){
+        if(e){
+            std::rethrow_exception(e);
+        }
+    }
+    return result;
+}
+
+template <class T>
+void evaluate_nodes(const plan<T>& p, const std::vector<bool>& needed, const typename plan<T>::atom_map& atoms, std::vector< zone_set<T> >& values){
+    for(std::size_t id = 0; id < p.size(); id++){
+        if(needed[id]){
+            values[id] = plan<T>::apply(p.node(id), atoms, values);
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ *  @brief  Evaluates one plan over many traces in parallel
+ *  @param  p       A plan with a single output
+ *  @param  traces  Match sets of the atoms, one map per trace
+ *  @param  num_threads   Number of workers, `0` for all hardware threads
+ *  @param  keep_matches  Whether to return the result of every trace or only its summary
+ */
+template <class T>
+batch_result<T> evaluate_batch(
+    const plan<T>& p,
+    const std::vector< typename plan<T>::atom_map >& traces,
+    unsigned num_threads = 0,
+    bool keep_matches = true){
+
+    return detail::run_batch(p, traces.size(), num_threads, keep_matches,
+        [&](std::size_t i, const std::vector<bool>& needed, std::vector< zone_set<T> >& values){
+            detail::evaluate_nodes(p, needed, traces[i], values);
+        });
+}
+
+/**
+ *  @brief  Evaluates one plan over the raw signals of many traces in parallel
+ *  @param  p       A plan with a single output
+ *  @param  traces  Sampled signals, one %signal_trace per trace
+ *  @param  atoms   For every atom of the plan, the predicate that defines it
+ *
+ *  Atoms are ingested by the worker that evaluates the trace, so the match
+ *  sets of a trace only live while it is evaluated.
+ */
+template <class T>
+batch_result<T> evaluate_batch(
+    const plan<T>& p,
+    const std::vector< signal_trace<T> >& traces,
+    const std::map< std::string, predicate<T> >& atoms,
+    unsigned num_threads = 0,
+    bool keep_matches = true){
+
+    return detail::run_batch(p, traces.size(), num_threads, keep_matches,
+        [&](std::size_t i, const std::vector<bool>& needed, std::vector< zone_set<T> >& values){
+            const signal_trace<T>& trace = traces[i];
+            std::map< std::string, zone_set<T> > sets;
+            typename plan<T>::atom_map pointers;
+            for(const auto& a : atoms){
+                if(a.second.signal >= trace.signals.size()){
+                    throw std::invalid_argument("evaluate_batch: predicate of atom '" + a.first + "' refers to a missing signal");
+                }
+                zone_set<T>& zs = sets[a.first];
+                zs = ingest_signal(trace.times, trace.signals[a.second.signal], trace.samples, a.second);
+                pointers[a.first] = &zs;
+            }
+            detail::evaluate_nodes(p, needed, pointers, values);
+        });
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_BATCH_HPP
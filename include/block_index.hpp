@@ -0,0 +1,157 @@
+#ifndef TIMEDREL_BLOCK_INDEX_HPP
+#define TIMEDREL_BLOCK_INDEX_HPP 1
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+namespace timedrel {
+
+/*
+ *  Value hull of a block of consecutive zones: the smallest box whose
+ *  bounds include every zone of the block. Strictness is ignored, so the
+ *  summary is conservative.
+ */
+template <class T>
+struct block_summary {
+    T bmin, bmax, emin, emax, dmin, dmax;
+};
+
+/**
+ *  @brief  Summarizes consecutive blocks of zones
+ *  @param  first  Iterator to the first zone
+ *  @param  last   Iterator past the last zone
+ *  @param  block_size  Zones per block (the last block may be shorter)
+ *  @return One %block_summary per block
+ */
+template <class T, class Iterator>
+std::vector< block_summary<T> > make_block_summaries(Iterator first, Iterator last, std::size_t block_size){
+
+    std::vector< block_summary<T> > result;
+    if(block_size == 0){
+        return result;
+    }
+
+    std::size_t k = 0;
+    for(auto it = first; it != last; it++, k++){
+        if(k % block_size == 0){
+            result.push_back(block_summary<T>{
+                it->get_bmin().value, it->get_bmax().value,
+                it->get_emin().value, it->get_emax().value,
+                it->get_dmin().value, it->get_dmax().value});
+        } else {
+            auto& s = result.back();
+            s.bmin = std::min(s.bmin, it->get_bmin().value);
+            s.bmax = std::max(s.bmax, it->get_bmax().value);
+            s.emin = std::min(s.emin, it->get_emin().value);
+            s.emax = std::max(s.emax, it->get_emax().value);
+            s.dmin = std::min(s.dmin, it->get_dmin().value);
+            s.dmax = std::max(s.dmax, it->get_dmax().value);
+        }
+    }
+    return result;
+}
+
+/* Whether the box `outer` includes the box `inner` */
+template <class T>
+bool summary_includes(const block_summary<T>& outer, const block_summary<T>& inner){
+    return !(inner.bmin < outer.bmin) and !(outer.bmax < inner.bmax) and
+           !(inner.emin < outer.emin) and !(outer.emax < inner.emax) and
+           !(inner.dmin < outer.dmin) and !(outer.dmax < inner.dmax);
+}
+
+/*
+ *  Summaries of the consecutive blocks of a zone sequence, as attached to a
+ *  %zone_set by `zone_set::build_block_index`.
+ */
+template <class T>
+struct block_index {
+    std::size_t block_size;
+    std::vector< block_summary<T> > blocks;
+};
+
+/* Whether the boxes `a` and `b` meet, bounds compared as closed */
+template <class T>
+bool summary_meets(const block_summary<T>& a, const block_summary<T>& b){
+    return !(a.bmax < b.bmin) and !(b.bmax < a.bmin) and
+           !(a.emax < b.emin) and !(b.emax < a.emin) and
+           !(a.dmax < b.dmin) and !(b.dmax < a.dmin);
+}
+
+/*
+ *  Average number of zones a swept zone is paired with, above which
+ *  `zone_set::intersection` joins its operands through a %block_tree if
+ *  the boxes also separate most of those pairs on e.
+ */
+const std::size_t tree_join_density = 32;
+
+/*
+ *  Hierarchy of block summaries over a sequence of zones: level 0 holds the
+ *  box of every zone and each level above summarizes `fanout` consecutive
+ *  boxes of the level below, up to a single root. Over zones sorted by bmin
+ *  the boxes of a level are narrow on b and, for most zones, on e.
+ */
+template <class T>
+class block_tree {
+
+public:
+    template <class Iterator>
+    block_tree(Iterator first, Iterator last, std::size_t fanout = 8) : fanout(fanout < 2 ? 2 : fanout) {
+        levels.push_back(make_block_summaries<T>(first, last, 1));
+        while(levels.back().size() > 1){
+            const std::vector< block_summary<T> >& below = levels.back();
+            std::vector< block_summary<T> > above;
+            above.reserve(below.size() / this->fanout + 1);
+            for(std::size_t k = 0; k < below.size(); k++){
+                if(k % this->fanout == 0){
+                    above.push_back(below[k]);
+                } else {
+                    block_summary<T>& s = above.back();
+                    s.bmin = std::min(s.bmin, below[k].bmin);
+                    s.bmax = std::max(s.bmax, below[k].bmax);
+                    s.emin = std::min(s.emin, below[k].emin);
+                    s.emax = std::max(s.emax, below[k].emax);
+                    s.dmin = std::min(s.dmin, below[k].dmin);
+                    s.dmax = std::max(s.dmax, below[k].dmax);
+                }
+            }
+            levels.push_back(std::move(above));
+        }
+    }
+
+    /* Calls `f(k)` for the position `k` of every zone whose box meets `q` */
+    template <class F>
+    void query(const block_summary<T>& q, F f) const {
+        if(!levels.front().empty()){
+            visit(levels.size() - 1, 0, q, f);
+        }
+    }
+
+    std::size_t size() const {
+        return levels.front().size();
+    }
+
+private:
+    std::size_t fanout;
+    std::vector< std::vector< block_summary<T> > > levels;
+
+    template <class F>
+    void visit(std::size_t level, std::size_t k, const block_summary<T>& q, F& f) const {
+        if(!summary_meets(levels[level][k], q)){
+            return;
+        }
+        if(level == 0){
+            f(k);
+            return;
+        }
+        std::size_t last = std::min((k + 1) * fanout, levels[level - 1].size());
+        for(std::size_t j = k * fanout; j < last; j++){
+            visit(level - 1, j, q, f);
+        }
+    }
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_BLOCK_INDEX_HPP
@@ -40,7 +40,7 @@ friend std::ostream& operator<<(std::ostream &os, const bound<T1>&);
     }
     static T minus_infinity(){
         return (std::numeric_limits<T>::has_infinity) ?
-        std::numeric_limits<T>::infinity() :
+        -std::numeric_limits<T>::infinity() :
         -std::numeric_limits<T>::max()/2;
     }
 
@@ -106,7 +106,7 @@ struct lower_bound : bound<T>{
                (this->value == other.value and this->sign > other.sign);
     }
 
-    upper_bound_type complement(){
+    upper_bound_type complement() const {
         return lower_bound_type::complementation(*this);
     }
 
@@ -175,7 +175,7 @@ struct upper_bound : public bound<T> {
                (this->value == other.value && this->sign < other.sign);
     }
 
-    lower_bound_type complement(){
+    lower_bound_type complement() const {
         return upper_bound_type::complementation(*this);
     }
 
@@ -224,6 +224,149 @@ struct upper_bound : public bound<T> {
 };
 
 
+/*
+ *  Bounds of zones whose constraints are all non-strict, see `closed_zone`.
+ *
+ *  Only the value is stored and `sign` is always true, so comparisons,
+ *  inclusion and intersection reduce to comparing values. The sign given
+ *  to the constructors is dropped, which takes the closure of a strict
+ *  bound. There is no complementation since it would need strict bounds.
+ */
+template <class T> struct closed_bound;
+template <class T> struct closed_lower_bound;
+template <class T> struct closed_upper_bound;
+
+template <class T>
+struct closed_bound {
+
+    typedef T                     value_type;
+    typedef closed_bound<T>       bound_type;
+
+    typedef closed_lower_bound<T> lower_bound_type;
+    typedef closed_upper_bound<T> upper_bound_type;
+
+    T value;
+    static constexpr bool sign = true;
+
+    static T infinity(){
+        return bound<T>::infinity();
+    }
+    static T minus_infinity(){
+        return bound<T>::minus_infinity();
+    }
+
+    static const auto zero = 0;
+
+    explicit closed_bound(T v, bool = true) : value(v) {}
+
+    bool operator==(const bound_type& other) const {
+        return value == other.value;
+    }
+
+    bool operator<(const bound_type& other) const {
+        return value < other.value;
+    }
+
+    static bool is_valid_interval(const lower_bound_type& l, const upper_bound_type& u){
+        return l.value <= u.value;
+    }
+};
+
+template <class T>
+constexpr bool closed_bound<T>::sign;
+
+template <class T>
+struct closed_lower_bound : closed_bound<T> {
+
+    typedef T                     value_type;
+    typedef closed_lower_bound<T> type;
+
+    typedef closed_lower_bound<T> lower_bound_type;
+    typedef closed_upper_bound<T> upper_bound_type;
+
+    explicit closed_lower_bound(T v, bool p = true) : closed_bound<T>(v, p){}
+
+    bool operator<(const lower_bound_type& other) const {
+        return this->value < other.value;
+    }
+
+    bool operator<(const upper_bound_type& other) const {
+        return this->value < other.value;
+    }
+
+    static bool includes(const lower_bound_type& b1, const lower_bound_type& b2){
+        return b1.value <= b2.value;
+    }
+
+    static lower_bound_type intersection(const lower_bound_type& b1, const lower_bound_type& b2){
+        return (b1.value < b2.value) ? b2 : b1;
+    }
+
+    static lower_bound_type add(const lower_bound_type& b1, const lower_bound_type& b2){
+        return lower_bound_type(b1.value + b2.value);
+    }
+    static lower_bound_type add(const lower_bound_type& b1, const upper_bound_type& b2){
+        return lower_bound_type(b1.value - b2.value);
+    }
+    static lower_bound_type add(const upper_bound_type& b1, const lower_bound_type& b2){
+        return lower_bound_type(b2.value - b1.value);
+    }
+
+    static lower_bound_type strict(T v){ return lower_bound_type(v);}
+    static lower_bound_type nonstrict(T v){ return lower_bound_type(v);}
+
+    static lower_bound_type open(T v){ return lower_bound_type(v);}
+    static lower_bound_type closed(T v){ return lower_bound_type(v);}
+
+    static lower_bound_type unbounded(){ return lower_bound_type(type::minus_infinity());}
+};
+
+template <class T>
+struct closed_upper_bound : closed_bound<T> {
+
+    typedef T                     value_type;
+    typedef closed_upper_bound<T> type;
+
+    typedef closed_lower_bound<T> lower_bound_type;
+    typedef closed_upper_bound<T> upper_bound_type;
+
+    explicit closed_upper_bound(T v, bool p = true) : closed_bound<T>(v, p){}
+
+    bool operator<(const upper_bound_type& other) const {
+        return this->value < other.value;
+    }
+
+    bool operator<(const lower_bound_type& other) const {
+        return this->value < other.value;
+    }
+
+    static bool includes(const upper_bound_type& b1, const upper_bound_type& b2){
+        return b1.value >= b2.value;
+    }
+
+    static upper_bound_type intersection(const upper_bound_type& b1, const upper_bound_type& b2){
+        return (b2.value < b1.value) ? b2 : b1;
+    }
+
+    static upper_bound_type add(const upper_bound_type& b1, const upper_bound_type& b2){
+        return upper_bound_type(b1.value + b2.value);
+    }
+    static upper_bound_type add(const lower_bound_type& b1, const upper_bound_type& b2){
+        return upper_bound_type(b2.value - b1.value);
+    }
+    static upper_bound_type add(const upper_bound_type& b1, const lower_bound_type& b2){
+        return upper_bound_type(b1.value - b2.value);
+    }
+
+    static upper_bound_type strict(T v){ return upper_bound_type(v);}
+    static upper_bound_type nonstrict(T v){ return upper_bound_type(v);}
+
+    static upper_bound_type open(T v){ return upper_bound_type(v);}
+    static upper_bound_type closed(T v){ return upper_bound_type(v);}
+
+    static upper_bound_type unbounded(){ return upper_bound_type(type::infinity());}
+};
+
 } // namespace timedrel
 
 #endif // TIMEDREL_BOUND_HPP
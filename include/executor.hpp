@@ -0,0 +1,272 @@
+#ifndef TIMEDREL_EXECUTOR_HPP
+#define TIMEDREL_EXECUTOR_HPP 1
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+
+#include "parallel.hpp"
+#include "plan.hpp"
+
+namespace timedrel {
+
+/**
+ *  A fixed pool of threads with one task deque per thread.
+ *
+ *  Tasks submitted from a worker go to the back of its own deque and are
+ *  popped from there (LIFO, so a parent runs right after its last input on
+ *  the same core); idle workers steal from the front of the other deques.
+ *  Tasks submitted from outside the pool are spread round-robin.
+ */
+class work_stealing_pool {
+
+public:
+    typedef std::function<void()> task_type;
+
+    explicit work_stealing_pool(unsigned num_threads = 0) : queued(0), stop(false), next(0) {
+        if(num_threads == 0){
+            num_threads = hardware_threads();
+        }
+        for(unsigned k = 0; k < num_threads; k++){
+            queues.emplace_back(new queue());
+        }
+        for(unsigned k = 0; k < num_threads; k++){
+            workers.push_back(std::thread(&work_stealing_pool::run, this, k));
+        }
+    }
+
+    ~work_stealing_pool(){
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            stop = true;
+        }
+        idle.notify_all();
+        for(auto& w : workers){
+            w.join();
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    unsigned size() const {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    /* Whether the calling thread is one of the workers of this pool */
+    bool on_worker() const {
+        return current_pool() == this;
+    }
+
+    void submit(task_type task){
+        std::size_t k = (current_pool() == this) ? current_index() : next++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[k]->mutex);
+            queues[k]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            queued++;
+        }
+        idle.notify_one();
+    }
+
+private:
+    struct queue {
+        std::mutex mutex;
+        std::deque<task_type> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    std::size_t queued;
+    bool stop;
+    std::atomic<std::size_t> next;
+
+    static const work_stealing_pool*& current_pool(){
+        static thread_local const work_stealing_pool* pool = nullptr;
+        return pool;
+    }
+
+    static std::size_t& current_index(){
+        static thread_local std::size_t index = 0;
+        return index;
+    }
+
+    bool pop(std::size_t k, task_type& task){
+        queue& own = *queues[k];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.tasks.empty()){
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for(std::size_t i = 1; i < queues.size(); i++){
+            queue& other = *queues[(k + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if(!other.tasks.empty()){
+                task = std::move(other.tasks.front());
+                other.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(std::size_t k){
+        current_pool() = this;
+        current_index() = k;
+
+        task_type task;
+        for(;;){
+            {
+                std::unique_lock<std::mutex> lock(idle_mutex);
+                idle.wait(lock, [this]{ return stop or queued > 0; });
+                if(queued == 0){
+                    return;
+                }
+                queued--;
+            }
+            /* A task is reserved for us, it is in some deque */
+            while(!pop(k, task)){
+                std::this_thread::yield();
+            }
+            task();
+            task = nullptr;
+        }
+    }
+};
+
+/**
+ *  @brief  Evaluates every output of a plan on a thread pool
+ *  @param  p      A plan
+ *  @param  atoms  Match sets of the atoms by name
+ *  @param  pool   The pool that runs the operator calls
+ *  @return One %zone_set per output, in order
+ *
+ *  Each reachable node becomes a task once all of its operands are computed,
+ *  so independent branches run concurrently, and intermediate results are
+ *  released after their last consumer. Operators are the sequential ones
+ *  and the results are the same as `plan::evaluate_all`. The first
+ *  exception thrown by an operator is rethrown here.
+ *
+ *  The calling thread blocks until the plan is done, so it must not be a
+ *  worker of `pool`: that would deadlock once every worker waits, and it
+ *  throws std::logic_error instead.
+ */
+template <class T>
+std::vector<zone_set<T>> evaluate_parallel(const plan<T>& p, const typename plan<T>::atom_map& atoms, work_stealing_pool& pool){
+
+    typedef zone_set<T> zone_set_type;
+
+    if(pool.on_worker()){
+        throw std::logic_error("evaluate_parallel: called from a worker of its own pool");
+    }
+
+    const auto& nodes = p.nodes();
+    std::vector<bool> needed = p.reachable();
+
+    std::vector<zone_set_type> values(nodes.size());
+    std::vector<std::vector<std::size_t>> parents(nodes.size());
+    std::unique_ptr<std::atomic<std::size_t>[]> waiting(new std::atomic<std::size_t>[nodes.size()]);
+
+    std::vector<std::size_t> counts = p.use_counts(needed);
+    std::unique_ptr<std::atomic<std::size_t>[]> uses(new std::atomic<std::size_t>[nodes.size()]);
+
+    std::size_t count = 0;
+    for(std::size_t id = 0; id < nodes.size(); id++){
+        uses[id] = counts[id];
+        waiting[id] = 0;
+        if(needed[id]){
+            count++;
+            for(auto a : nodes[id].args){
+                parents[a].push_back(id);
+                waiting[id]++;
+            }
+        }
+    }
+
+    std::atomic<std::size_t> remaining(count);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex done_mutex;
+    std::condition_variable done;
+
+    std::function<void(std::size_t)> schedule;
+    schedule = [&](std::size_t id){
+        pool.submit([&, id]{
+            if(!failed){
+                try {
+                    values[id] = plan<T>::apply(nodes[id], atoms, values);
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock(done_mutex);
+                    if(!failed.exchange(true)){
+                        error = std::current_exception();
+                    }
+                }
+            }
+            /* Operands whose last consumer this was are released */
+            for(auto a : nodes[id].args){
+                if(--uses[a] == 0){
+                    values[a] = zone_set_type();
+                }
+            }
+            /* Parents still run after a failure, as no-ops, so that every task completes */
+            for(auto parent : parents[id]){
+                if(--waiting[parent] == 0){
+                    schedule(parent);
+                }
+            }
+            /* Under the lock, so the waiter cannot return and destroy it before we are done */
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if(--remaining == 0){
+                done.notify_all();
+            }
+        });
+    };
+
+    for(std::size_t id = 0; id < nodes.size(); id++){
+        if(needed[id] and nodes[id].args.empty()){
+            schedule(id);
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&]{ return remaining == 0; });
+    }
+
+    if(error){
+        std::rethrow_exception(error);
+    }
+
+    for(std::size_t id = 0; id < nodes.size(); id++){
+        counts[id] = uses[id];
+    }
+    return p.collect(values, counts);
+}
+
+/**
+ *  @brief  Evaluates every output of a plan on a new pool of `num_threads` threads (0 = all)
+ */
+template <class T>
+std::vector<zone_set<T>> evaluate_parallel(const plan<T>& p, const typename plan<T>::atom_map& atoms, unsigned num_threads = 0){
+    work_stealing_pool pool(num_threads);
+    return evaluate_parallel(p, atoms, pool);
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_EXECUTOR_HPP
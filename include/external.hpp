@@ -0,0 +1,457 @@
+#ifndef TIMEDREL_EXTERNAL_HPP
+#define TIMEDREL_EXTERNAL_HPP 1
+
+#include <queue>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "zone.hpp"
+#include "zone_set.hpp"
+#include "serialization.hpp"
+
+namespace timedrel {
+
+/*
+ *  Out-of-core evaluation.
+ *
+ *  A large zone set is kept on disk as an ordered list of segment files in the
+ *  binary zone_set format; concatenating the segments gives the whole set.
+ *  The operators below read their inputs one mapped segment at a time, keep only
+ *  the active lists of the sweep in memory and write their output as sorted
+ *  runs that are merged into bmin-sorted output segments.
+ */
+struct external_options {
+    std::string directory = ".";
+    std::string prefix = "zone_set";
+    std::size_t memory_budget = std::size_t(256) << 20;   // bytes for zone buffers
+    std::size_t block_size = 64;                          // block index of written segments
+
+    template <class T>
+    std::size_t buffer_zones() const {
+        return std::max<std::size_t>(1024, memory_budget / (2 * sizeof(zone<T>)));
+    }
+
+    std::string next_path() const {
+        static std::atomic<unsigned long> counter(0);
+        return directory + "/" + prefix + "-" + std::to_string(::getpid()) + "-" +
+               std::to_string(counter++) + ".zs";
+    }
+};
+
+/**
+ *  Sequential reader over a list of segment files. Only the current segment is mapped.
+ */
+template <class T>
+class segment_reader {
+
+public:
+    typedef zone<T> zone_type;
+
+    explicit segment_reader(const std::vector<std::string>& paths) : paths(paths) {
+        open_next();
+    }
+
+    bool done() const {
+        return !mapped;
+    }
+    const zone_type& get() const {
+        return current.front();
+    }
+    void next(){
+        if(++position < mapped->size()){
+            current.front() = (*mapped)[position];
+        } else {
+            open_next();
+        }
+    }
+
+private:
+    std::vector<std::string> paths;
+    std::size_t file = 0;
+    std::size_t position = 0;
+    std::unique_ptr< mapped_zone_set<T> > mapped;
+    std::vector<zone_type> current;   // the decoded zone at `position`, reused while streaming
+
+    void open_next(){
+        mapped.reset();
+        while(file < paths.size()){
+            mapped.reset(new mapped_zone_set<T>(paths[file++]));
+            if(!mapped->empty()){
+                mapped->advise_sequential();
+                position = 0;
+                if(current.empty()){
+                    current.push_back((*mapped)[0]);
+                } else {
+                    current.front() = (*mapped)[0];
+                }
+                return;
+            }
+            mapped.reset();
+        }
+    }
+};
+
+/**
+ *  Buffers zones and writes them as segment files of bounded size.
+ *  With a comparator every segment is sorted before it is written (a run).
+ */
+template <class T>
+class segment_writer {
+
+public:
+    typedef zone<T>     zone_type;
+    typedef zone_set<T> zone_set_type;
+
+    explicit segment_writer(const external_options& options, bool sort_runs = false) :
+        options(options), capacity(options.buffer_zones<T>()), sort_runs(sort_runs) {}
+
+    void push(const zone_type& z){
+        buffer.push_back(z);
+        if(buffer.size() >= capacity){
+            flush();
+        }
+    }
+
+    std::vector<std::string> finish(){
+        flush();
+        return std::move(paths);
+    }
+
+private:
+    external_options options;
+    std::size_t capacity;
+    bool sort_runs;
+    zone_set_type buffer;
+    std::vector<std::string> paths;
+
+    void flush(){
+        if(buffer.empty()){
+            return;
+        }
+        if(sort_runs){
+            buffer.sort_by_bmin();
+        }
+        paths.push_back(options.next_path());
+        save(buffer, paths.back(), options.block_size);
+        buffer.clear();
+    }
+};
+
+/**
+ *  @brief  Writes an in-memory zone set as segments of at most `buffer_zones` zones each
+ */
+template <class T>
+std::vector<std::string> write_segments(const zone_set<T>& zs, const external_options& options){
+    segment_writer<T> writer(options);
+    for(const auto& z : zs){
+        writer.push(z);
+    }
+    return writer.finish();
+}
+
+/**
+ *  @brief  Reads a list of segments back into memory
+ */
+template <class T>
+zone_set<T> read_segments(const std::vector<std::string>& paths){
+    zone_set<T> result;
+    for(segment_reader<T> reader(paths); !reader.done(); reader.next()){
+        result.push_back(reader.get());
+    }
+    return result;
+}
+
+/**
+ *  @brief  Removes segment files, e.g. intermediate results that are no longer needed
+ */
+inline void remove_segments(const std::vector<std::string>& paths){
+    for(const auto& p : paths){
+        std::remove(p.c_str());
+    }
+}
+
+/**
+ *  @brief  Merges sorted runs into sorted segments
+ *  @param  runs     Segments each sorted by bmin, or by emin (left untouched)
+ *  @param  by_emin  The runs are sorted by emin instead of bmin
+ *  @return Sorted output segments
+ */
+template <class T>
+std::vector<std::string> merge_runs(
+    const std::vector<std::string>& runs,
+    const external_options& options,
+    bool by_emin = false){
+
+    typedef zone<T> zone_type;
+
+    auto before = [by_emin](const zone_type& z1, const zone_type& z2){
+        return by_emin ? (z1.get_emin() < z2.get_emin()) : (z1.get_bmin() < z2.get_bmin());
+    };
+
+    std::vector< std::unique_ptr< segment_reader<T> > > readers;
+    for(const auto& r : runs){
+        readers.emplace_back(new segment_reader<T>(std::vector<std::string>(1, r)));
+    }
+
+    auto later = [&readers, &before](std::size_t a, std::size_t b){
+        return before(readers[b]->get(), readers[a]->get());
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heads(later);
+    for(std::size_t k = 0; k < readers.size(); k++){
+        if(!readers[k]->done()){
+            heads.push(k);
+        }
+    }
+
+    segment_writer<T> writer(options);
+    while(!heads.empty()){
+        std::size_t k = heads.top();
+        heads.pop();
+        writer.push(readers[k]->get());
+        readers[k]->next();
+        if(!readers[k]->done()){
+            heads.push(k);
+        }
+    }
+    return writer.finish();
+}
+
+/**
+ *  @brief  External merge sort of a segment list
+ *  @param  paths    Input segments (left untouched)
+ *  @param  by_emin  Sort by emin instead of bmin
+ *  @return Sorted output segments
+ *
+ *  Sorted runs of `buffer_zones` zones are written first and then merged in one pass.
+ */
+template <class T>
+std::vector<std::string> external_sort(
+    const std::vector<std::string>& paths,
+    const external_options& options,
+    bool by_emin = false){
+
+    auto sort_buffer = [by_emin](zone_set<T>& zs){
+        if(by_emin){
+            zs.sort_by_emin();
+        } else {
+            zs.sort_by_bmin();
+        }
+    };
+
+    // Runs
+    std::vector<std::string> runs;
+    {
+        zone_set<T> buffer;
+        std::size_t capacity = options.buffer_zones<T>();
+        for(segment_reader<T> reader(paths); !reader.done(); reader.next()){
+            buffer.push_back(reader.get());
+            if(buffer.size() >= capacity){
+                sort_buffer(buffer);
+                runs.push_back(options.next_path());
+                save(buffer, runs.back(), 0);
+                buffer.clear();
+            }
+        }
+        if(!buffer.empty() or runs.empty()){
+            sort_buffer(buffer);
+            runs.push_back(options.next_path());
+            save(buffer, runs.back(), 0);
+        }
+    }
+
+    std::vector<std::string> result = merge_runs<T>(runs, options, by_emin);
+    remove_segments(runs);
+    return result;
+}
+
+namespace detail {
+
+/*
+ *  The dominance-filtered insertion of `kid` into the active result list used
+ *  by the in-memory sweeps; zones whose bmax is behind `horizon` are final.
+ */
+template <class Zone, class Bound, class Sink>
+void insert_active_result(std::vector<Zone>& act_r, std::vector<Zone>& act_r_temp, const Zone& kid, const Bound& horizon, Sink& sink){
+
+    if(!kid.is_nonempty() or
+       std::any_of(act_r.begin(), act_r.end(), [&kid](const Zone& zr){return Zone::includes(zr, kid);})){
+        return;
+    }
+    act_r.erase(std::remove_if(act_r.begin(), act_r.end(), [&kid](const Zone& zr){return Zone::includes(kid, zr);}), act_r.end());
+    act_r.push_back(kid);
+
+    act_r_temp.clear();
+    for(const auto& zr : act_r){
+        if(zr.get_bmax() < horizon){
+            sink.push(zr);
+        } else {
+            act_r_temp.push_back(zr);
+        }
+    }
+    act_r.swap(act_r_temp);
+}
+
+/*
+ *  Forward sweep of two sorted streams shared by the external intersection and
+ *  concatenation, mirroring `zone_set::intersection` and `zone_set::concatenation`:
+ *  the left stream is ordered by `key1` (bmin or emin), the right one by bmin.
+ *  Only the pairs accepted by `pairs` are combined.
+ */
+template <class T, class Key1, class Expired1, class Pairs, class Combine, class Sink>
+void external_sweep(segment_reader<T>& r1, segment_reader<T>& r2, Key1 key1, Expired1 expired1, Pairs pairs, Combine combine, Sink& sink){
+
+    typedef zone<T> zone_type;
+
+    std::vector<zone_type> act_1, act_2, act_r, act_r_temp;
+
+    while(!r1.done() or !r2.done()){
+
+        if(!r1.done() and (r2.done() or key1(r1.get()) < r2.get().get_bmin())){
+            const zone_type z1 = r1.get();
+            if(!r2.done()){
+                act_1.push_back(z1);
+            }
+            act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](const zone_type& z2){return z2.get_bmax() < key1(z1);}), act_2.end());
+            for(const auto& z2 : act_2){
+                if(pairs(z1, z2)){
+                    insert_active_result(act_r, act_r_temp, combine(z1, z2), z1.get_bmin(), sink);
+                }
+            }
+            r1.next();
+        } else {
+            const zone_type z2 = r2.get();
+            if(!r1.done()){
+                act_2.push_back(z2);
+            }
+            act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](const zone_type& z1){return expired1(z1, z2);}), act_1.end());
+            for(const auto& z1 : act_1){
+                if(pairs(z1, z2)){
+                    insert_active_result(act_r, act_r_temp, combine(z1, z2), z2.get_bmin(), sink);
+                }
+            }
+            r2.next();
+        }
+    }
+    for(const auto& zr : act_r){
+        sink.push(zr);
+    }
+}
+
+} // namespace detail
+
+/**
+ *  @brief  Out-of-core `zone_set::filter`
+ *  @param  paths  bmin-sorted input segments
+ *  @return bmin-sorted output segments
+ */
+template <class T>
+std::vector<std::string> external_filter(const std::vector<std::string>& paths, const external_options& options){
+
+    typedef zone<T> zone_type;
+
+    segment_writer<T> runs(options, true);
+    std::vector<zone_type> active, active_temp;
+
+    for(segment_reader<T> reader(paths); !reader.done(); reader.next()){
+        const zone_type& z1 = reader.get();
+        if(std::any_of(active.begin(), active.end(), [&z1](const zone_type& z2){return zone_type::includes(z2, z1);})){
+            continue;
+        }
+        active.erase(std::remove_if(active.begin(), active.end(), [&z1](const zone_type& z2){return zone_type::includes(z1, z2);}), active.end());
+        active.push_back(z1);
+
+        active_temp.clear();
+        for(const auto& z2 : active){
+            if(z2.get_bmax() < z1.get_bmin()){
+                runs.push(z2);
+            } else {
+                active_temp.push_back(z2);
+            }
+        }
+        active.swap(active_temp);
+    }
+    for(const auto& z2 : active){
+        runs.push(z2);
+    }
+
+    std::vector<std::string> sorted_runs = runs.finish();
+    std::vector<std::string> result = merge_runs<T>(sorted_runs, options);
+    remove_segments(sorted_runs);
+    return result;
+}
+
+/**
+ *  @brief  Out-of-core `zone_set::intersection`
+ *  @param  paths1  bmin-sorted segments of the first operand
+ *  @param  paths2  bmin-sorted segments of the second operand
+ *  @return bmin-sorted output segments
+ */
+template <class T>
+std::vector<std::string> external_intersection(
+    const std::vector<std::string>& paths1,
+    const std::vector<std::string>& paths2,
+    const external_options& options){
+
+    typedef zone<T> zone_type;
+    typedef typename zone_type::lower_bound_type lower_bound_type;
+
+    segment_writer<T> runs(options, true);
+    segment_reader<T> r1(paths1), r2(paths2);
+
+    detail::external_sweep<T>(r1, r2,
+        [](const zone_type& z) -> lower_bound_type {return z.get_bmin();},
+        [](const zone_type& z1, const zone_type& z2){return z1.get_bmax() < z2.get_bmin();},
+        [](const zone_type&, const zone_type&){return true;},
+        [](const zone_type& z1, const zone_type& z2){return zone_type::intersection(z1, z2);},
+        runs);
+
+    std::vector<std::string> sorted_runs = runs.finish();
+    std::vector<std::string> result = merge_runs<T>(sorted_runs, options);
+    remove_segments(sorted_runs);
+    return result;
+}
+
+/**
+ *  @brief  Out-of-core `zone_set::concatenation`
+ *  @param  paths1  Segments of the first operand (any order, sorted by emin internally)
+ *  @param  paths2  bmin-sorted segments of the second operand
+ *  @return bmin-sorted output segments
+ */
+template <class T>
+std::vector<std::string> external_concatenation(
+    const std::vector<std::string>& paths1,
+    const std::vector<std::string>& paths2,
+    const external_options& options){
+
+    typedef zone<T> zone_type;
+    typedef typename zone_type::lower_bound_type lower_bound_type;
+
+    std::vector<std::string> by_emin = external_sort<T>(paths1, options, true);
+
+    segment_writer<T> runs(options, true);
+    {
+        segment_reader<T> r1(by_emin), r2(paths2);
+        detail::external_sweep<T>(r1, r2,
+            [](const zone_type& z) -> lower_bound_type {return z.get_emin();},
+            [](const zone_type& z1, const zone_type& z2){return z1.get_emax() < z2.get_bmin();},
+            [](const zone_type& z1, const zone_type& z2){return zone_type::meets(z1, z2);},
+            [](const zone_type& z1, const zone_type& z2){return zone_type::concatenation(z1, z2);},
+            runs);
+    }
+    remove_segments(by_emin);
+
+    std::vector<std::string> sorted_runs = runs.finish();
+    std::vector<std::string> result = merge_runs<T>(sorted_runs, options);
+    remove_segments(sorted_runs);
+    return result;
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_EXTERNAL_HPP
@@ -0,0 +1,108 @@
+#ifndef TIMEDREL_HASHING_HPP
+#define TIMEDREL_HASHING_HPP 1
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#include <gmpxx.h>
+
+#include "bound.hpp"
+#include "zone.hpp"
+#include "rational.hpp"
+
+namespace timedrel {
+
+/*
+ *  64-bit content hashing of values, bounds and zones. Equal values hash
+ *  equally, so `-0.0` and `0.0` hash the same and rationals are hashed in
+ *  canonical form.
+ */
+namespace hashing {
+
+inline std::uint64_t mix(std::uint64_t h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline std::uint64_t combine(std::uint64_t seed, std::uint64_t h){
+    return mix(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+inline std::uint64_t value(double v){
+    if(v == 0){
+        v = 0;
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return mix(bits);
+}
+
+inline std::uint64_t value(long long v){
+    return mix(static_cast<std::uint64_t>(v));
+}
+
+inline std::uint64_t value(const mpz_class& v){
+    std::uint64_t h = static_cast<std::uint64_t>(mpz_sgn(v.get_mpz_t()) + 1);
+    std::size_t n = mpz_size(v.get_mpz_t());
+    for(std::size_t i = 0; i < n; i++){
+        h = combine(h, static_cast<std::uint64_t>(mpz_getlimbn(v.get_mpz_t(), i)));
+    }
+    return h;
+}
+
+inline std::uint64_t value(const mpq_class& v){
+    mpq_class c(v);
+    c.canonicalize();
+    return combine(value(c.get_num()), value(c.get_den()));
+}
+
+inline std::uint64_t value(const rational& v){
+    if(v.is_small()){
+        return combine(value(static_cast<long long>(v.small_numerator())), value(static_cast<long long>(v.small_denominator())));
+    }
+    return value(v.get_mpq());
+}
+
+template <class T>
+std::uint64_t value(const bound<T>& b){
+    return combine(value(b.value), b.sign ? 1 : 0);
+}
+
+template <class T>
+std::uint64_t value(const closed_bound<T>& b){
+    return combine(value(b.value), 1);
+}
+
+template <class T, class Bound>
+std::uint64_t value(const zone<T, Bound>& z){
+    std::uint64_t h = value(z.get_bmin());
+    h = combine(h, value(z.get_bmax()));
+    h = combine(h, value(z.get_emin()));
+    h = combine(h, value(z.get_emax()));
+    h = combine(h, value(z.get_dmin()));
+    h = combine(h, value(z.get_dmax()));
+    return h;
+}
+
+} // namespace hashing
+
+} // namespace timedrel
+
+namespace std {
+
+/* Content hash of a zone, equal for zones that compare equal */
+template <class T, class Bound>
+struct hash<timedrel::zone<T, Bound>> {
+    std::size_t operator()(const timedrel::zone<T, Bound>& z) const {
+        return static_cast<std::size_t>(timedrel::hashing::value(z));
+    }
+};
+
+} // namespace std
+
+#endif // TIMEDREL_HASHING_HPP
@@ -0,0 +1,311 @@
+#ifndef TIMEDREL_INGESTION_HPP
+#define TIMEDREL_INGESTION_HPP 1
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <exception>
+
+#include "zone.hpp"
+#include "zone_set.hpp"
+#include "parallel.hpp"
+
+namespace timedrel {
+
+enum class comparison { gt, geq, lt, leq };
+
+/*
+ *  An atomic proposition over one sampled signal, e.g. `x > 3`.
+ *
+ *  With a nonzero hysteresis the proposition switches on when the comparison
+ *  against `threshold` holds and stays on until it fails against the threshold
+ *  moved by `hysteresis` in the opposite direction (`threshold - hysteresis`
+ *  for gt/geq, `threshold + hysteresis` for lt/leq).
+ */
+template <class T>
+struct predicate {
+
+    typedef T value_type;
+
+    std::size_t   signal;
+    comparison    op;
+    T             threshold;
+    T             hysteresis;
+    period_anchor anchor;
+
+    predicate(std::size_t s, comparison c, T thr, T hyst = 0, period_anchor a = period_anchor::none) :
+        signal(s), op(c), threshold(thr), hysteresis(hyst), anchor(a) {}
+
+    T stay_threshold() const {
+        return (op == comparison::gt or op == comparison::geq) ?
+            threshold - hysteresis : threshold + hysteresis;
+    }
+};
+
+namespace detail {
+
+/*
+ *  Samples are evaluated in blocks into a byte mask so that the comparison loop
+ *  vectorizes; runs of equal bytes are then skipped eight at a time.
+ */
+static const std::size_t ingestion_block = 4096;
+
+template <class T>
+inline void fill_mask(const T* values, std::size_t n, const predicate<T>& p, const T& thr, std::uint8_t* mask){
+    switch(p.op){
+        case comparison::gt:  for(std::size_t i = 0; i < n; i++){ mask[i] = values[i] >  thr; } break;
+        case comparison::geq: for(std::size_t i = 0; i < n; i++){ mask[i] = values[i] >= thr; } break;
+        case comparison::lt:  for(std::size_t i = 0; i < n; i++){ mask[i] = values[i] <  thr; } break;
+        default:              for(std::size_t i = 0; i < n; i++){ mask[i] = values[i] <= thr; } break;
+    }
+}
+
+/*
+ *  Returns the first index in [i, n) whose mask byte differs from `state`, or n.
+ */
+inline std::size_t next_change(const std::uint8_t* mask, std::size_t i, std::size_t n, bool state){
+    const std::uint64_t run = state ? 0x0101010101010101ULL : 0;
+    while(i + 8 <= n){
+        std::uint64_t word;
+        std::memcpy(&word, mask + i, 8);
+        if(word != run){
+            break;
+        }
+        i += 8;
+    }
+    while(i < n and bool(mask[i]) == state){
+        i++;
+    }
+    return i;
+}
+
+} // namespace detail
+
+/**
+ *  @brief  Extracts the maximal periods where a predicate holds on a sampled signal
+ *  @param  times   n nondecreasing sample times
+ *  @param  values  n sample values
+ *  @param  n       Number of samples
+ *  @param  p       %predicate (its `signal` field is ignored here)
+ *  @return %zone_set with one zone per maximal true period, sorted by bmin
+ *
+ *  Signals are piecewise-constant: a period starts at the first sample where
+ *  the predicate holds and ends at the first later sample where it does not,
+ *  or at the last sample. Zones are built with the anchor of the predicate.
+ *  Throws std::invalid_argument if the times decrease or the hysteresis is negative.
+ */
+template <class T>
+zone_set<T> ingest_signal(const T* times, const T* values, std::size_t n, const predicate<T>& p){
+
+    typedef zone<T> zone_type;
+
+    zone_set<T> result;
+
+    if(p.hysteresis < 0){
+        throw std::invalid_argument("ingest_signal: hysteresis must be nonnegative");
+    }
+    bool decreasing = false;
+    for(std::size_t i = 1; i < n; i++){
+        decreasing |= (times[i] < times[i-1]);
+    }
+    if(decreasing){
+        throw std::invalid_argument("ingest_signal: sample times must be nondecreasing");
+    }
+
+    std::vector<std::uint8_t> on(detail::ingestion_block), stay;
+    if(p.hysteresis != 0){
+        stay.resize(detail::ingestion_block);
+    }
+
+    const T stay_threshold = p.stay_threshold();
+
+    bool state = false;
+    std::size_t rise = 0;
+
+    for(std::size_t first = 0; first < n; first += detail::ingestion_block){
+
+        std::size_t len = std::min(detail::ingestion_block, n - first);
+
+        detail::fill_mask(values + first, len, p, p.threshold, on.data());
+        if(!stay.empty()){
+            detail::fill_mask(values + first, len, p, stay_threshold, stay.data());
+        }
+
+        std::size_t i = 0;
+        while(i < len){
+            // Switched off, look for the next sample that switches on.
+            // Switched on, look for the next sample that fails to stay on.
+            i = state ? detail::next_change(stay.empty() ? on.data() : stay.data(), i, len, true)
+                      : detail::next_change(on.data(), i, len, false);
+            if(i == len){
+                break;
+            }
+            if(state){
+                result.add(zone_type::make_from_period(times[rise], times[first + i], p.anchor));
+            } else {
+                rise = first + i;
+            }
+            state = not state;
+        }
+    }
+
+    if(state){
+        result.add(zone_type::make_from_period(times[rise], times[n-1], p.anchor));
+    }
+
+    return result;
+}
+
+/**
+ *  Collects periods and merges the ones that overlap or touch before any
+ *  zone is built, e.g. [0,10], [10,15] and [15.1,20] give [0,15] and
+ *  [15.1,20], or a single [0,20] with a gap tolerance of 0.1.
+ *
+ *  A period is merged into the previous one (in begin order) when it begins
+ *  at most `gap_tolerance` after that one ends. `build` returns one zone per
+ *  merged period; `saved` tells how many periods were absorbed by merges and
+ *  `dropped` how many merged periods gave an empty zone, e.g. [t, t].
+ *
+ *  Only with `period_anchor::none` is the result a period list (see
+ *  `zone_set::is_period_list`), on which the boolean operators run as
+ *  interval merges; anchored zones take the zone sweeps.
+ */
+template <class T>
+class period_coalescer {
+
+public:
+    typedef T value_type;
+
+    explicit period_coalescer(T gap_tolerance = 0, period_anchor anchor = period_anchor::none) :
+        gap(gap_tolerance), anchor(anchor) {
+        if(gap_tolerance < 0){
+            throw std::invalid_argument("period_coalescer: gap tolerance must be nonnegative");
+        }
+    }
+
+    /* Adds [begin, end]; periods with begin > end are ignored as in `zone_set::add_from_period` */
+    void add(T begin, T end){
+        if(!(begin == begin) or !(end == end)){
+            throw std::invalid_argument("period_coalescer: NaN in period");
+        }
+        if(end < begin){
+            return;
+        }
+        periods.emplace_back(begin, end);
+    }
+
+    /**
+     *  @brief  Zones of the merged periods
+     *  @return %zone_set sorted by bmin, built with the anchor of the coalescer
+     *
+     *  The periods added so far are kept, so more can be added and `build`
+     *  called again.
+     */
+    zone_set<T> build(){
+
+        typedef zone<T> zone_type;
+
+        zone_set<T> result;
+        saved_zones = 0;
+        dropped_zones = 0;
+
+        std::sort(periods.begin(), periods.end());
+        for(std::size_t i = 0; i < periods.size(); ){
+            T begin = periods[i].first;
+            T end = periods[i].second;
+            for(i++; i < periods.size() and !(end + gap < periods[i].first); i++){
+                if(end < periods[i].second){
+                    end = periods[i].second;
+                }
+                saved_zones++;
+            }
+            zone_type z = zone_type::make_from_period(begin, end, anchor);
+            if(z.is_nonempty()){
+                result.push_back(z);
+            } else {
+                dropped_zones++;
+            }
+        }
+        return result;
+    }
+
+    /* Number of periods added and not ignored */
+    std::size_t size() const {
+        return periods.size();
+    }
+
+    /* Number of periods the last `build` merged into an earlier one */
+    std::size_t saved() const {
+        return saved_zones;
+    }
+
+    /* Number of merged periods the last `build` dropped because their zone was empty */
+    std::size_t dropped() const {
+        return dropped_zones;
+    }
+
+    void clear(){
+        periods.clear();
+        saved_zones = 0;
+        dropped_zones = 0;
+    }
+
+private:
+    T gap;
+    period_anchor anchor;
+    std::vector< std::pair<T, T> > periods;
+    std::size_t saved_zones = 0;
+    std::size_t dropped_zones = 0;
+};
+
+/**
+ *  @brief  Turns several sampled signals into one match set per atomic proposition
+ *  @param  times        n shared sample times
+ *  @param  signals      Pointers to n values per signal
+ *  @param  n            Number of samples
+ *  @param  predicates   Atomic propositions; `signal` indexes into `signals`
+ *  @param  num_threads  Propositions are processed in parallel (0 uses all hardware threads)
+ *  @return One %zone_set per predicate, in order
+ */
+template <class T>
+std::vector< zone_set<T> > ingest_signals(
+    const T* times,
+    const std::vector<const T*>& signals,
+    std::size_t n,
+    const std::vector< predicate<T> >& predicates,
+    unsigned num_threads = 1){
+
+    for(const auto& p : predicates){
+        if(p.signal >= signals.size()){
+            throw std::invalid_argument("ingest_signals: predicate refers to a missing signal");
+        }
+    }
+
+    std::vector< zone_set<T> > result(predicates.size());
+    std::vector<std::exception_ptr> errors(predicates.size());
+
+    parallel_for(predicates.size(), num_threads, [&](std::size_t first, std::size_t last, unsigned){
+        for(std::size_t k = first; k < last; k++){
+            try {
+                result[k] = ingest_signal(times, signals[predicates[k].signal], n, predicates[k]);
+            } catch(...) {
+                errors[k] = std::current_exception();
+            }
+        }
+    });
+
+    for(const auto& e : errors){
+        if(e){
+            std::rethrow_exception(e);
+        }
+    }
+    return result;
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_INGESTION_HPP
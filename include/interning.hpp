@@ -0,0 +1,75 @@
+#ifndef TIMEDREL_INTERNING_HPP
+#define TIMEDREL_INTERNING_HPP 1
+
+#include <cstddef>
+#include <unordered_set>
+
+#include "hashing.hpp"
+
+namespace timedrel {
+
+/*
+ *  Counts of a %zone_interner since it was built or cleared.
+ */
+struct zone_interner_stats {
+    std::size_t lookups = 0;
+    std::size_t duplicates = 0;
+    std::size_t entries = 0;
+
+    /* Fraction of lookups that found the zone already interned */
+    double duplicate_rate() const {
+        return lookups == 0 ? 0.0 : double(duplicates) / double(lookups);
+    }
+};
+
+/**
+ *  Table of the distinct zones seen during one evaluation.
+ *
+ *  Zones built by `zone::make` are canonical, so equal zones have equal
+ *  bounds and exact duplicates are found by hashing in constant time,
+ *  before they reach the pairwise inclusion checks of `zone_set::filter`.
+ *  Not thread-safe.
+ */
+template <class Zone>
+class zone_interner {
+
+public:
+    typedef Zone zone_type;
+
+    /* Whether `z` was not interned yet, interning it if so */
+    bool insert(const zone_type& z){
+        stats_.lookups++;
+        if(zones.insert(z).second){
+            return true;
+        }
+        stats_.duplicates++;
+        return false;
+    }
+
+    bool contains(const zone_type& z) const {
+        return zones.count(z) != 0;
+    }
+
+    std::size_t size() const {
+        return zones.size();
+    }
+
+    void clear(){
+        zones.clear();
+        stats_ = zone_interner_stats();
+    }
+
+    zone_interner_stats stats() const {
+        zone_interner_stats s = stats_;
+        s.entries = zones.size();
+        return s;
+    }
+
+private:
+    std::unordered_set<zone_type> zones;
+    zone_interner_stats stats_;
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_INTERNING_HPP
@@ -0,0 +1,150 @@
+#ifndef TIMEDREL_LONG_ZONES_HPP
+#define TIMEDREL_LONG_ZONES_HPP 1
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+namespace timedrel {
+
+/*
+ *  A zone is long for a sweep when its key interval holds more than this
+ *  many sweep events, i.e. it would stay in an active list that long.
+ */
+const std::size_t long_zone_events = 64;
+
+/*
+ *  Centered interval tree over the key intervals [lo, hi] of the long zones.
+ *
+ *  Each node keeps the intervals that contain its center, once sorted by lo
+ *  and once by hi, and passes the ones entirely before or after the center
+ *  to its children. The center is the lo of the median interval, so every
+ *  node holds at least that one and the depth is logarithmic. A query costs
+ *  O(log n + k) for k reported intervals, whatever their lengths. Bounds are
+ *  compared as closed, so the answer may include intervals that only touch
+ *  the query.
+ */
+template <class T>
+class long_zone_index {
+
+public:
+    typedef T value_type;
+
+    void add(const T& lo, const T& hi, std::size_t id){
+        entries.push_back(entry{lo, hi, id});
+    }
+
+    /* Builds the tree over the entries added so far, to be called before `query` */
+    void build(){
+        nodes.clear();
+        by_lo.clear();
+        by_hi.clear();
+        std::vector<entry> items(entries);
+        std::sort(items.begin(), items.end(), [](const entry& a, const entry& b){ return a.lo < b.lo; });
+        root = build_node(items);
+    }
+
+    /* Calls `f(id)` for every entry whose interval meets [lo, hi] */
+    template <class F>
+    void query(const T& lo, const T& hi, F f) const {
+        visit(root, lo, hi, [&f](std::size_t id){ f(id); return false; });
+    }
+
+    /* Whether some entry meets [lo, hi] */
+    bool overlaps(const T& lo, const T& hi) const {
+        return visit(root, lo, hi, [](std::size_t){ return true; });
+    }
+
+    std::size_t size() const {
+        return entries.size();
+    }
+
+private:
+    struct entry {
+        T lo, hi;
+        std::size_t id;
+    };
+
+    /* Entries [first, last) of `by_lo` and `by_hi` contain `center` */
+    struct node {
+        T center;
+        std::size_t first, last;
+        std::size_t before, after;
+    };
+
+    static const std::size_t none = std::size_t(-1);
+
+    std::vector<entry> entries;
+    std::vector<node> nodes;
+    std::vector<entry> by_lo;   // ascending lo within a node
+    std::vector<entry> by_hi;   // descending hi within a node
+    std::size_t root = none;
+
+    /* `items` sorted by lo */
+    std::size_t build_node(const std::vector<entry>& items){
+        if(items.empty()){
+            return none;
+        }
+        T center = items[items.size() / 2].lo;
+
+        std::vector<entry> before, after;
+        std::size_t first = by_lo.size();
+        for(const auto& e : items){
+            if(e.hi < center){
+                before.push_back(e);
+            } else if(center < e.lo){
+                after.push_back(e);
+            } else {
+                by_lo.push_back(e);
+                by_hi.push_back(e);
+            }
+        }
+        std::sort(by_hi.begin() + first, by_hi.end(), [](const entry& a, const entry& b){ return b.hi < a.hi; });
+
+        std::size_t k = nodes.size();
+        nodes.push_back(node{center, first, by_lo.size(), none, none});
+        std::size_t b = build_node(before);
+        std::size_t a = build_node(after);
+        nodes[k].before = b;
+        nodes[k].after = a;
+        return k;
+    }
+
+    /* Calls `f(id)` on the entries of the subtree at `k` meeting [lo, hi], stops when it returns true */
+    template <class F>
+    bool visit(std::size_t k, const T& lo, const T& hi, const F& f) const {
+        while(k != none){
+            const node& n = nodes[k];
+            if(hi < n.center){
+                for(std::size_t i = n.first; i < n.last and !(hi < by_lo[i].lo); i++){
+                    if(f(by_lo[i].id)){
+                        return true;
+                    }
+                }
+                k = n.before;
+            } else if(n.center < lo){
+                for(std::size_t i = n.first; i < n.last and !(by_hi[i].hi < lo); i++){
+                    if(f(by_hi[i].id)){
+                        return true;
+                    }
+                }
+                k = n.after;
+            } else {
+                for(std::size_t i = n.first; i < n.last; i++){
+                    if(f(by_lo[i].id)){
+                        return true;
+                    }
+                }
+                if(visit(n.before, lo, hi, f)){
+                    return true;
+                }
+                k = n.after;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_LONG_ZONES_HPP
@@ -0,0 +1,431 @@
+#ifndef TIMEDREL_ONLINE_HPP
+#define TIMEDREL_ONLINE_HPP 1
+
+#include <deque>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "bound.hpp"
+#include "zone.hpp"
+#include "zone_set.hpp"
+
+namespace timedrel {
+
+/**
+ *  Incremental evaluation of a TRE operator graph over append-only inputs.
+ *
+ *  Atoms receive completed periods in time order. `advance(t)` declares that
+ *  every period beginning before `t` has been pushed; each node then runs its
+ *  sweep as far as the watermarks of its inputs allow, keeps only the active
+ *  lists of the batch sweep (act_1, act_2, act_r) and finalizes a zone once
+ *  its bmax is behind the point where no later zone can interact with it.
+ *  Every edge of the graph carries zones in bmin order together with a
+ *  watermark below which no further zone will arrive, so memory is bounded by
+ *  the time horizon of the pattern instead of the length of the trace.
+ *
+ *  Up to dominated zones, the zones emitted for a node are the zones of the
+ *  batch operator on the full inputs. Zones are assumed to have nonnegative
+ *  durations (emin >= bmin), which holds for all period-built atoms.
+ */
+template <class T>
+class online_monitor {
+
+public:
+    typedef T                                    value_type;
+    typedef zone<T>                              zone_type;
+    typedef zone_set<T>                          zone_set_type;
+    typedef typename zone_type::bound_type       bound_type;
+    typedef typename zone_type::lower_bound_type lower_bound_type;
+    typedef typename zone_type::upper_bound_type upper_bound_type;
+    typedef std::size_t                          node_id;
+
+    online_monitor() : output(0), current(-bound_type::infinity()) {}
+
+    node_id atom(period_anchor anchor = period_anchor::none){
+        node_id id = add_node(op::atom, 0, 0);
+        nodes[id].anchor = anchor;
+        return id;
+    }
+
+    node_id intersection(node_id a, node_id b){
+        return add_node(op::intersection, a, b);
+    }
+
+    node_id set_union(node_id a, node_id b){
+        return add_node(op::set_union, a, b);
+    }
+
+    node_id concatenation(node_id a, node_id b){
+        return add_node(op::concatenation, a, b);
+    }
+
+    node_id duration_restriction(node_id a, const lower_bound_type& dmin, const upper_bound_type& dmax){
+        node_id id = add_node(op::duration_restriction, a, a);
+        nodes[id].dmin = dmin;
+        nodes[id].dmax = dmax;
+        return id;
+    }
+
+    node_id duration_restriction(node_id a, const value_type dmin, const value_type dmax){
+        return duration_restriction(a, lower_bound_type::open(dmin), upper_bound_type::closed(dmax));
+    }
+
+    /*
+     *  Selects the node whose finalized zones are returned (the last node by default).
+     */
+    void set_output(node_id id){
+        check(id);
+        output = id;
+    }
+
+    /*
+     *  Adds a completed period of an atom. Its begin must not be behind the watermark.
+     */
+    void push_period(node_id id, value_type begin, value_type end){
+        check(id);
+        if(nodes[id].kind != op::atom){
+            throw std::invalid_argument("online_monitor: periods can only be pushed to atoms");
+        }
+        if(begin < current){
+            throw std::invalid_argument("online_monitor: period begins before the watermark");
+        }
+        zone_type z = zone_type::make_from_period(begin, end, nodes[id].anchor);
+        if(z.is_nonempty()){
+            push_heap_by_bmin(nodes[id].out, z);
+        }
+    }
+
+    /*
+     *  Moves the watermark to `t` and returns the newly finalized output zones, sorted by bmin.
+     */
+    zone_set_type advance(value_type t){
+        if(t < current){
+            throw std::invalid_argument("online_monitor: the watermark cannot move backwards");
+        }
+        current = t;
+        return run(false);
+    }
+
+    /*
+     *  Ends the input and returns all remaining output zones.
+     */
+    zone_set_type finish(){
+        current = bound_type::infinity();
+        return run(true);
+    }
+
+    value_type watermark() const {
+        return current;
+    }
+
+    /*
+     *  Number of zones currently held in queues and active lists.
+     */
+    std::size_t resident_zones() const {
+        std::size_t n = 0;
+        for(const auto& nd : nodes){
+            n += nd.in[0].size() + nd.in[1].size() + nd.pending.size() +
+                 nd.act_1.size() + nd.act_2.size() + nd.act_r.size() + nd.out.size();
+        }
+        return n;
+    }
+
+private:
+
+    enum class op { atom, intersection, set_union, concatenation, duration_restriction };
+
+    struct node {
+        op kind;
+        node_id left, right;
+        period_anchor anchor;
+        lower_bound_type dmin;
+        upper_bound_type dmax;
+
+        value_type in_wm[2];
+        std::deque<zone_type> in[2];        // bmin-ordered inputs
+        std::vector<zone_type> pending;     // emin-heap (concatenation) or bmin-heap (restriction)
+        std::vector<zone_type> act_1, act_2, act_r;
+        std::vector<zone_type> out;         // bmin-heap of finalized zones
+        value_type out_wm;
+        std::vector< std::pair<node_id, int> > consumers;
+
+        node(op k, node_id l, node_id r, value_type wm) :
+            kind(k), left(l), right(r), anchor(period_anchor::none),
+            dmin(lower_bound_type::unbounded()), dmax(upper_bound_type::unbounded()),
+            out_wm(wm) {
+            in_wm[0] = in_wm[1] = wm;
+        }
+    };
+
+    std::vector<node> nodes;
+    node_id output;
+    value_type current;
+    std::vector<zone_type> scratch;
+
+    void check(node_id id) const {
+        if(id >= nodes.size()){
+            throw std::out_of_range("online_monitor: unknown node");
+        }
+    }
+
+    node_id add_node(op kind, node_id a, node_id b){
+        if(kind != op::atom){
+            check(a);
+            check(b);
+        }
+        node_id id = nodes.size();
+        nodes.push_back(node(kind, a, b, current));
+        if(kind != op::atom){
+            nodes[a].consumers.push_back(std::make_pair(id, 0));
+            if(kind != op::duration_restriction){
+                nodes[b].consumers.push_back(std::make_pair(id, 1));
+            }
+        }
+        output = id;
+        return id;
+    }
+
+    static bool later_bmin(const zone_type& z1, const zone_type& z2){
+        return z2.get_bmin() < z1.get_bmin();
+    }
+    static bool later_emin(const zone_type& z1, const zone_type& z2){
+        return z2.get_emin() < z1.get_emin();
+    }
+    static void push_heap_by_bmin(std::vector<zone_type>& heap, const zone_type& z){
+        heap.push_back(z);
+        std::push_heap(heap.begin(), heap.end(), later_bmin);
+    }
+    static value_type min_bmin(const std::vector<zone_type>& zs, value_type v){
+        for(const auto& z : zs){
+            v = std::min(v, z.get_bmin().value);
+        }
+        return v;
+    }
+
+    /*
+     *  Inserts a zone into an active result list unless it is dominated,
+     *  removing the zones it dominates (the filter step of the batch sweeps).
+     */
+    static void insert_maximal(std::vector<zone_type>& act, const zone_type& kid){
+        if(!kid.is_nonempty() or
+           std::any_of(act.begin(), act.end(), [&kid](const zone_type& zr){return zone_type::includes(zr, kid);})){
+            return;
+        }
+        act.erase(std::remove_if(act.begin(), act.end(), [&kid](const zone_type& zr){return zone_type::includes(kid, zr);}), act.end());
+        act.push_back(kid);
+    }
+
+    /*
+     *  Moves zones of `act` with bmax behind `horizon` (all of them if `all`) to the output heap.
+     */
+    static void finalize(node& n, std::vector<zone_type>& act, value_type horizon, bool all){
+        auto last = std::partition(act.begin(), act.end(), [horizon, all](const zone_type& z){
+            return !(all or z.get_bmax().value < horizon);
+        });
+        for(auto it = last; it != act.end(); it++){
+            push_heap_by_bmin(n.out, *it);
+        }
+        act.erase(last, act.end());
+    }
+
+    static void expire(std::vector<zone_type>& act, value_type horizon){
+        act.erase(std::remove_if(act.begin(), act.end(), [horizon](const zone_type& z){
+            return z.get_bmax().value < horizon;
+        }), act.end());
+    }
+
+    /*
+     *  The input whose head comes next in bmin order, or -1 if that is not known yet.
+     */
+    static int next_input(const node& n){
+        bool h0 = !n.in[0].empty(), h1 = !n.in[1].empty();
+        if(h0 and h1){
+            return (n.in[0].front().get_bmin() < n.in[1].front().get_bmin()) ? 0 : 1;
+        }
+        if(h0 and n.in[0].front().get_bmin().value < n.in_wm[1]){
+            return 0;
+        }
+        if(h1 and n.in[1].front().get_bmin().value < n.in_wm[0]){
+            return 1;
+        }
+        return -1;
+    }
+
+    static value_type input_horizon(const node& n, int k){
+        return n.in[k].empty() ? n.in_wm[k] : n.in[k].front().get_bmin().value;
+    }
+
+    void deliver(node_id id, int slot, const zone_type& z){
+        node& n = nodes[id];
+        if(n.kind == op::concatenation and slot == 0){
+            n.pending.push_back(z);
+            std::push_heap(n.pending.begin(), n.pending.end(), later_emin);
+        } else {
+            n.in[slot].push_back(z);
+        }
+    }
+
+    zone_set_type run(bool final){
+
+        zone_set_type result;
+
+        for(node_id id = 0; id < nodes.size(); id++){
+            node& n = nodes[id];
+
+            if(n.kind != op::atom){
+                n.in_wm[0] = nodes[n.left].out_wm;
+                n.in_wm[1] = nodes[n.right].out_wm;
+            }
+
+            switch(n.kind){
+                case op::atom:                 n.out_wm = current; break;
+                case op::intersection:         step_intersection(n, final); break;
+                case op::set_union:            step_union(n, final); break;
+                case op::concatenation:        step_concatenation(n, final); break;
+                case op::duration_restriction: step_restriction(n, final); break;
+            }
+            if(final){
+                n.out_wm = bound_type::infinity();
+            }
+
+            // Release finalized zones in bmin order
+            while(!n.out.empty() and (final or n.out.front().get_bmin().value < n.out_wm)){
+                std::pop_heap(n.out.begin(), n.out.end(), later_bmin);
+                const zone_type z = std::move(n.out.back());
+                n.out.pop_back();
+                for(const auto& c : n.consumers){
+                    deliver(c.first, c.second, z);
+                }
+                if(id == output){
+                    result.push_back(z);
+                }
+            }
+        }
+        return result;
+    }
+
+    void step_intersection(node& n, bool final){
+        for(int k; (k = next_input(n)) >= 0; ){
+            const zone_type z = std::move(n.in[k].front());
+            n.in[k].pop_front();
+
+            std::vector<zone_type>& mine  = (k == 0) ? n.act_1 : n.act_2;
+            std::vector<zone_type>& other = (k == 0) ? n.act_2 : n.act_1;
+
+            mine.push_back(z);
+            other.erase(std::remove_if(other.begin(), other.end(), [&z](const zone_type& zo){return zo.get_bmax() < z.get_bmin();}), other.end());
+            for(const auto& zo : other){
+                insert_maximal(n.act_r, zone_type::intersection(z, zo));
+            }
+        }
+
+        value_type horizon = std::min(input_horizon(n, 0), input_horizon(n, 1));
+        expire(n.act_1, horizon);
+        expire(n.act_2, horizon);
+        finalize(n, n.act_r, horizon, final);
+        n.out_wm = min_bmin(n.act_r, horizon);
+    }
+
+    void step_union(node& n, bool final){
+        for(int k; (k = next_input(n)) >= 0; ){
+            insert_maximal(n.act_r, n.in[k].front());
+            n.in[k].pop_front();
+        }
+
+        value_type horizon = std::min(input_horizon(n, 0), input_horizon(n, 1));
+        finalize(n, n.act_r, horizon, final);
+        n.out_wm = min_bmin(n.act_r, horizon);
+    }
+
+    void step_restriction(node& n, bool final){
+        while(!n.in[0].empty()){
+            zone_type kid = zone_type::duration_restriction(n.in[0].front(), n.dmin, n.dmax);
+            n.in[0].pop_front();
+            if(kid.is_nonempty()){
+                push_heap_by_bmin(n.pending, kid);
+            }
+        }
+
+        // Restricted zones can only move their bmin forward, so the input watermark still holds.
+        value_type horizon = n.in_wm[0];
+        while(!n.pending.empty() and (final or n.pending.front().get_bmin().value < horizon)){
+            std::pop_heap(n.pending.begin(), n.pending.end(), later_bmin);
+            insert_maximal(n.act_r, n.pending.back());
+            n.pending.pop_back();
+        }
+
+        horizon = min_bmin(n.pending, horizon);
+        finalize(n, n.act_r, horizon, final);
+        n.out_wm = min_bmin(n.act_r, horizon);
+    }
+
+    void step_concatenation(node& n, bool final){
+
+        for(;;){
+            // Left zones are taken in emin order once no later left zone can precede them.
+            bool has_left  = !n.pending.empty() and n.pending.front().get_emin().value < n.in_wm[0];
+            bool has_right = !n.in[1].empty();
+            value_type left_horizon = n.pending.empty() ? n.in_wm[0] :
+                std::min(n.in_wm[0], n.pending.front().get_emin().value);
+
+            bool take_left;
+            if(has_left and has_right){
+                take_left = n.pending.front().get_emin() < n.in[1].front().get_bmin();
+            } else if(has_left){
+                take_left = true;
+                if(!(n.pending.front().get_emin().value < n.in_wm[1])){
+                    break;
+                }
+            } else if(has_right and n.in[1].front().get_bmin().value < left_horizon){
+                take_left = false;
+            } else {
+                break;
+            }
+
+            if(take_left){
+                std::pop_heap(n.pending.begin(), n.pending.end(), later_emin);
+                const zone_type z1 = std::move(n.pending.back());
+                n.pending.pop_back();
+
+                n.act_1.push_back(z1);
+                n.act_2.erase(std::remove_if(n.act_2.begin(), n.act_2.end(), [&z1](const zone_type& z2){return z2.get_bmax() < z1.get_emin();}), n.act_2.end());
+                for(const auto& z2 : n.act_2){
+                    if(zone_type::meets(z1, z2)){
+                        insert_maximal(n.act_r, zone_type::concatenation(z1, z2));
+                    }
+                }
+            } else {
+                const zone_type z2 = n.in[1].front();
+                n.in[1].pop_front();
+
+                n.act_2.push_back(z2);
+                n.act_1.erase(std::remove_if(n.act_1.begin(), n.act_1.end(), [&z2](const zone_type& z1){return z1.get_emax() < z2.get_bmin();}), n.act_1.end());
+                for(const auto& z1 : n.act_1){
+                    if(zone_type::meets(z1, z2)){
+                        insert_maximal(n.act_r, zone_type::concatenation(z1, z2));
+                    }
+                }
+            }
+        }
+
+        value_type left_horizon = n.pending.empty() ? n.in_wm[0] :
+            std::min(n.in_wm[0], n.pending.front().get_emin().value);
+        value_type right_horizon = input_horizon(n, 1);
+
+        // Left zones wait for right zones beginning before their emax and vice versa.
+        n.act_1.erase(std::remove_if(n.act_1.begin(), n.act_1.end(), [right_horizon](const zone_type& z1){
+            return z1.get_emax().value < right_horizon;}), n.act_1.end());
+        expire(n.act_2, left_horizon);
+
+        // Concatenations keep the bmin of their left zone.
+        value_type horizon = min_bmin(n.act_1, min_bmin(n.pending, n.in_wm[0]));
+        finalize(n, n.act_r, horizon, final);
+        n.out_wm = min_bmin(n.act_r, horizon);
+    }
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_ONLINE_HPP
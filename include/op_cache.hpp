@@ -0,0 +1,201 @@
+#ifndef TIMEDREL_OP_CACHE_HPP
+#define TIMEDREL_OP_CACHE_HPP 1
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <initializer_list>
+
+#include "hashing.hpp"
+#include "zone_set.hpp"
+
+namespace timedrel {
+
+/*
+ *  Hit and miss counts of an %operator_cache.
+ */
+struct operator_cache_stats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t collisions = 0;
+    std::size_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t capacity = 0;
+};
+
+/**
+ *  Bounded LRU cache of operator results.
+ *
+ *  Results are looked up by the operator name, the fingerprints and sizes
+ *  of the operands and the parameters. Every entry also keeps a copy of its
+ *  operands, and a hit is only returned when they equal the current ones,
+ *  so a fingerprint collision costs a recomputation (counted in
+ *  `collisions`) instead of returning the result of another set. A capacity
+ *  of 0 disables the cache and calls go straight to the operator without
+ *  fingerprinting. Thread-safe; the operator and the operand comparison run
+ *  outside the lock.
+ */
+template <class T>
+class operator_cache {
+
+public:
+    typedef zone_set<T> zone_set_type;
+
+    explicit operator_cache(std::size_t capacity = 0) : capacity_(capacity) {}
+
+    operator_cache(const operator_cache&) = delete;
+    operator_cache& operator=(const operator_cache&) = delete;
+
+    /**
+     *  @brief  Result of `compute()`, from the cache when possible
+     *  @param  op        Operator name
+     *  @param  operands  Operand sets
+     *  @param  params    Operator parameters
+     *  @param  compute   Computes the result on a miss
+     */
+    template <class Compute>
+    zone_set_type apply(
+        const std::string& op,
+        std::initializer_list<const zone_set_type*> operands,
+        std::initializer_list<T> params,
+        Compute compute){
+
+        if(capacity() == 0){
+            return compute();
+        }
+
+        key_type k{op, std::vector<std::uint64_t>()};
+        for(auto zs : operands){
+            k.words.push_back(zs->fingerprint());
+            k.words.push_back(zs->size());
+        }
+        for(const auto& v : params){
+            k.words.push_back(hashing::value(v));
+        }
+
+        std::shared_ptr<const entry_type> found;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(k);
+            if(it != index.end()){
+                entries.splice(entries.begin(), entries, it->second);
+                found = it->second->second;
+            }
+        }
+
+        if(found and same_operands(*found, operands)){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stats_.hits++;
+            }
+            return found->result;
+        }
+
+        zone_set_type result = compute();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(found){
+            stats_.collisions++;
+        } else {
+            stats_.misses++;
+        }
+        if(capacity_ > 0 and index.find(k) == index.end()){
+            std::shared_ptr<entry_type> e = std::make_shared<entry_type>();
+            for(auto zs : operands){
+                e->operands.push_back(*zs);
+            }
+            e->result = result;
+            entries.emplace_front(k, std::move(e));
+            index[k] = entries.begin();
+            shrink();
+        }
+        return result;
+    }
+
+    std::size_t capacity() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return capacity_;
+    }
+
+    /* Changes the capacity, evicting the least recently used results if needed */
+    void set_capacity(std::size_t capacity){
+        std::lock_guard<std::mutex> lock(mutex);
+        capacity_ = capacity;
+        shrink();
+    }
+
+    operator_cache_stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        operator_cache_stats s = stats_;
+        s.entries = entries.size();
+        s.capacity = capacity_;
+        return s;
+    }
+
+    /* Drops every result and resets the counts */
+    void clear(){
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        index.clear();
+        stats_ = operator_cache_stats();
+    }
+
+private:
+    struct key_type {
+        std::string op;
+        std::vector<std::uint64_t> words;
+
+        bool operator==(const key_type& other) const {
+            return op == other.op and words == other.words;
+        }
+    };
+
+    struct key_hash {
+        std::size_t operator()(const key_type& k) const {
+            std::uint64_t h = std::hash<std::string>()(k.op);
+            for(auto w : k.words){
+                h = hashing::combine(h, w);
+            }
+            return static_cast<std::size_t>(h);
+        }
+    };
+
+    /* A stored result with the operands it was computed from */
+    struct entry_type {
+        std::vector<zone_set_type> operands;
+        zone_set_type result;
+    };
+
+    static bool same_operands(const entry_type& e, std::initializer_list<const zone_set_type*> operands){
+        return operands.size() == e.operands.size() and
+               std::equal(operands.begin(), operands.end(), e.operands.cbegin(),
+                          [](const zone_set_type* zs, const zone_set_type& stored){ return *zs == stored; });
+    }
+
+    typedef std::list< std::pair<key_type, std::shared_ptr<const entry_type> > > list_type;
+
+    mutable std::mutex mutex;
+    std::size_t capacity_;
+    list_type entries;
+    std::unordered_map<key_type, typename list_type::iterator, key_hash> index;
+    operator_cache_stats stats_;
+
+    void shrink(){
+        while(entries.size() > capacity_){
+            index.erase(entries.back().first);
+            entries.pop_back();
+            stats_.evictions++;
+        }
+    }
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_OP_CACHE_HPP
@@ -0,0 +1,82 @@
+#ifndef TIMEDREL_PARALLEL_HPP
+#define TIMEDREL_PARALLEL_HPP 1
+
+#include <vector>
+#include <thread>
+#include <cstddef>
+
+namespace timedrel {
+
+/**
+ *  Number of threads to use when the caller asks for `0` (automatic).
+ */
+inline unsigned hardware_threads(){
+    unsigned n = std::thread::hardware_concurrency();
+    return (n == 0) ? 1 : n;
+}
+
+/**
+ *  @brief  Runs `f(first, last, chunk)` over `num_threads` contiguous chunks of [0, n).
+ *
+ *  Chunks are processed on their own thread and joined before returning.
+ *  With a single thread (or tiny inputs) `f` is called inline on [0, n).
+ *  Passing `0` as the number of threads uses all hardware threads.
+ */
+template <class Function>
+void parallel_for(std::size_t n, unsigned num_threads, Function f){
+
+    if(num_threads == 0){
+        num_threads = hardware_threads();
+    }
+    if(num_threads > n){
+        num_threads = (n == 0) ? 1 : static_cast<unsigned>(n);
+    }
+    if(num_threads <= 1){
+        f(std::size_t(0), n, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads - 1);
+
+    std::size_t step = n / num_threads;
+    std::size_t rest = n % num_threads;
+    std::size_t first = 0;
+
+    for(unsigned k = 0; k < num_threads; k++){
+        std::size_t last = first + step + ((k < rest) ? 1 : 0);
+        if(k + 1 == num_threads){
+            f(first, last, k);
+        } else {
+            workers.push_back(std::thread(f, first, last, k));
+        }
+        first = last;
+    }
+    for(auto& w : workers){
+        w.join();
+    }
+}
+
+/**
+ *  Splits [0, n) into the same chunks as `parallel_for` and returns the chunk borders.
+ */
+inline std::vector<std::size_t> chunk_borders(std::size_t n, unsigned num_threads){
+    if(num_threads == 0){
+        num_threads = hardware_threads();
+    }
+    if(num_threads > n){
+        num_threads = (n == 0) ? 1 : static_cast<unsigned>(n);
+    }
+
+    std::vector<std::size_t> borders(1, 0);
+    std::size_t step = n / num_threads;
+    std::size_t rest = n % num_threads;
+    for(unsigned k = 0; k < num_threads; k++){
+        borders.push_back(borders.back() + step + ((k < rest) ? 1 : 0));
+    }
+    return borders;
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_PARALLEL_HPP
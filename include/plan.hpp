@@ -0,0 +1,355 @@
+#ifndef TIMEDREL_PLAN_HPP
+#define TIMEDREL_PLAN_HPP 1
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+
+#include "bound.hpp"
+#include "zone.hpp"
+#include "zone_set.hpp"
+
+namespace timedrel {
+
+enum class plan_op {
+    atom,
+    complementation,
+    intersection,
+    set_union,
+    set_difference,
+    concatenation,
+    transitive_closure,
+    duration_restriction,
+    concatenation_duration_restriction,
+    diamond_meets, diamond_met_by, diamond_starts, diamond_started_by, diamond_finishes, diamond_finished_by,
+    box_meets, box_met_by, box_starts, box_started_by, box_finishes, box_finished_by
+};
+
+inline const char* plan_op_name(plan_op op){
+    static const char* names[] = {
+        "atom", "complementation", "intersection", "union", "difference",
+        "concatenation", "transitive_closure", "duration_restriction", "concatenation_duration_restriction",
+        "diamond_meets", "diamond_met_by", "diamond_starts", "diamond_started_by", "diamond_finishes", "diamond_finished_by",
+        "box_meets", "box_met_by", "box_starts", "box_started_by", "box_finishes", "box_finished_by"
+    };
+    return names[static_cast<int>(op)];
+}
+
+inline bool is_bounded_op(plan_op op){
+    return op >= plan_op::duration_restriction;
+}
+
+inline bool is_commutative_op(plan_op op){
+    return op == plan_op::intersection or op == plan_op::set_union;
+}
+
+/*
+ *  A node of a query plan. Nodes refer to their operands by index and are
+ *  stored after them, so the node order is a topological order.
+ */
+template <class T>
+struct plan_node {
+
+    typedef lower_bound<T> lower_bound_type;
+    typedef upper_bound<T> upper_bound_type;
+
+    plan_op op;
+    std::vector<std::size_t> args;
+    std::string name;
+    lower_bound_type lbound;
+    upper_bound_type ubound;
+
+    plan_node(plan_op op, const std::vector<std::size_t>& args) :
+        op(op), args(args),
+        lbound(lower_bound_type::unbounded()), ubound(upper_bound_type::unbounded()) {}
+};
+
+/**
+ *  A DAG of %zone_set operations with common subexpressions shared.
+ *
+ *  Nodes are hash-consed on (operator, operands, parameters): building the same
+ *  subexpression twice returns the same node, with the operands of commutative
+ *  operators ordered. A plan is immutable once built and can be evaluated on
+ *  any number of atom assignments.
+ */
+template <class T>
+class plan {
+
+public:
+    typedef T                                     value_type;
+    typedef zone_set<T>                           zone_set_type;
+    typedef plan_node<T>                          node_type;
+    typedef typename node_type::lower_bound_type  lower_bound_type;
+    typedef typename node_type::upper_bound_type  upper_bound_type;
+    typedef std::map<std::string, const zone_set_type*> atom_map;
+
+    std::size_t atom(const std::string& name){
+        node_type n(plan_op::atom, std::vector<std::size_t>());
+        n.name = name;
+        return insert(n);
+    }
+
+    std::size_t unary(plan_op op, std::size_t a){
+        return insert(node_type(op, std::vector<std::size_t>(1, a)));
+    }
+
+    std::size_t binary(plan_op op, std::size_t a, std::size_t b){
+        if(is_commutative_op(op) and b < a){
+            std::swap(a, b);
+        }
+        std::vector<std::size_t> args;
+        args.push_back(a);
+        args.push_back(b);
+        return insert(node_type(op, args));
+    }
+
+    /*
+     *  A duration restriction of a concatenation becomes one fused node.
+     */
+    std::size_t bounded(plan_op op, std::size_t a, const lower_bound_type& lbound, const upper_bound_type& ubound){
+        node_type n(op, std::vector<std::size_t>(1, a));
+        if(op == plan_op::duration_restriction and node(a).op == plan_op::concatenation){
+            n.op = plan_op::concatenation_duration_restriction;
+            n.args = node(a).args;
+        }
+        n.lbound = lbound;
+        n.ubound = ubound;
+        return insert(n);
+    }
+
+    void add_output(std::size_t id){
+        outputs_.push_back(id);
+    }
+
+    const std::vector<std::size_t>& outputs() const {
+        return outputs_;
+    }
+    const std::vector<node_type>& nodes() const {
+        return nodes_;
+    }
+    const node_type& node(std::size_t id) const {
+        return nodes_.at(id);
+    }
+    std::size_t size() const {
+        return nodes_.size();
+    }
+
+    std::vector<std::string> atoms() const {
+        std::vector<std::string> result;
+        for(const auto& n : nodes_){
+            if(n.op == plan_op::atom){
+                result.push_back(n.name);
+            }
+        }
+        return result;
+    }
+
+    /**
+     *  @brief  Evaluates every output of the plan
+     *  @param  atoms  Match sets of the atoms by name
+     *  @return One %zone_set per output, in order
+     *
+     *  Only nodes reachable from an output are evaluated, each exactly once,
+     *  and an intermediate result is released as soon as its last consumer
+     *  has been evaluated.
+     */
+    std::vector<zone_set_type> evaluate_all(const atom_map& atoms) const {
+
+        std::vector<bool> needed = reachable();
+        std::vector<std::size_t> uses = use_counts(needed);
+        std::vector<zone_set_type> values(nodes_.size());
+
+        for(std::size_t id = 0; id < nodes_.size(); id++){
+            if(needed[id]){
+                values[id] = apply(nodes_[id], atoms, values);
+                for(auto a : nodes_[id].args){
+                    if(--uses[a] == 0){
+                        values[a] = zone_set_type();
+                    }
+                }
+            }
+        }
+
+        return collect(values, uses);
+    }
+
+    zone_set_type evaluate(const atom_map& atoms) const {
+        if(outputs_.size() != 1){
+            throw std::logic_error("plan::evaluate: the plan must have exactly one output");
+        }
+        return evaluate_all(atoms).front();
+    }
+
+    zone_set_type evaluate(const std::map<std::string, zone_set_type>& atoms) const {
+        atom_map pointers;
+        for(const auto& a : atoms){
+            pointers[a.first] = &a.second;
+        }
+        return evaluate(pointers);
+    }
+
+    /*
+     *  Applies the operator of node `n` given the values of its operands.
+     */
+    static zone_set_type apply(const node_type& n, const atom_map& atoms, const std::vector<zone_set_type>& values){
+
+        if(n.op == plan_op::atom){
+            auto it = atoms.find(n.name);
+            if(it == atoms.end()){
+                throw std::invalid_argument("plan: no match set given for atom '" + n.name + "'");
+            }
+            zone_set_type zs = *(it->second);
+            if(!zs.is_sorted_by_bmin()){
+                zs.sort_by_bmin();
+            }
+            return zs;
+        }
+
+        const zone_set_type& a = values[n.args[0]];
+        const zone_set_type& b = values[n.args.size() > 1 ? n.args[1] : n.args[0]];
+
+        switch(n.op){
+            case plan_op::complementation:     return zone_set_type::complementation(a);
+            case plan_op::intersection:        return zone_set_type::intersection(a, b);
+            case plan_op::set_union:           return zone_set_type::set_union(a, b);
+            case plan_op::set_difference:      return zone_set_type::set_difference(a, b);
+            case plan_op::concatenation:       return zone_set_type::concatenation(a, b);
+            case plan_op::transitive_closure:  return zone_set_type::transitive_closure(a);
+            case plan_op::duration_restriction:return zone_set_type::duration_restriction(a, n.lbound, n.ubound);
+            case plan_op::concatenation_duration_restriction:
+                return zone_set_type::concatenation_duration_restriction(a, b, n.lbound, n.ubound);
+            case plan_op::diamond_meets:       return zone_set_type::diamond_meets(a, n.lbound, n.ubound);
+            case plan_op::diamond_met_by:      return zone_set_type::diamond_met_by(a, n.lbound, n.ubound);
+            case plan_op::diamond_starts:      return zone_set_type::diamond_starts(a, n.lbound, n.ubound);
+            case plan_op::diamond_started_by:  return zone_set_type::diamond_started_by(a, n.lbound, n.ubound);
+            case plan_op::diamond_finishes:    return zone_set_type::diamond_finishes(a, n.lbound, n.ubound);
+            case plan_op::diamond_finished_by: return zone_set_type::diamond_finished_by(a, n.lbound, n.ubound);
+            case plan_op::box_meets:           return zone_set_type::box_meets(a, n.lbound, n.ubound);
+            case plan_op::box_met_by:          return zone_set_type::box_met_by(a, n.lbound, n.ubound);
+            case plan_op::box_starts:          return zone_set_type::box_starts(a, n.lbound, n.ubound);
+            case plan_op::box_started_by:      return zone_set_type::box_started_by(a, n.lbound, n.ubound);
+            case plan_op::box_finishes:        return zone_set_type::box_finishes(a, n.lbound, n.ubound);
+            case plan_op::box_finished_by:     return zone_set_type::box_finished_by(a, n.lbound, n.ubound);
+            default:                           throw std::logic_error("plan: unknown operator");
+        }
+    }
+
+    /*
+     *  Marks the nodes an output depends on.
+     */
+    std::vector<bool> reachable() const {
+        std::vector<bool> needed(nodes_.size(), false);
+        for(auto id : outputs_){
+            needed[id] = true;
+        }
+        for(std::size_t id = nodes_.size(); id-- > 0; ){
+            if(needed[id]){
+                for(auto a : nodes_[id].args){
+                    needed[a] = true;
+                }
+            }
+        }
+        return needed;
+    }
+
+    /*
+     *  Number of times the value of each needed node is read: once per
+     *  occurrence as an operand of a needed node and once per output.
+     */
+    std::vector<std::size_t> use_counts(const std::vector<bool>& needed) const {
+        std::vector<std::size_t> uses(nodes_.size(), 0);
+        for(std::size_t id = 0; id < nodes_.size(); id++){
+            if(needed[id]){
+                for(auto a : nodes_[id].args){
+                    uses[a]++;
+                }
+            }
+        }
+        for(auto id : outputs_){
+            uses[id]++;
+        }
+        return uses;
+    }
+
+    /*
+     *  Gathers the outputs from the node values, given the uses left on them:
+     *  the last output reading a value takes it, the others copy it.
+     */
+    std::vector<zone_set_type> collect(std::vector<zone_set_type>& values, std::vector<std::size_t>& uses) const {
+        std::vector<zone_set_type> result;
+        result.reserve(outputs_.size());
+        for(auto id : outputs_){
+            if(--uses[id] == 0){
+                result.push_back(std::move(values[id]));
+            } else {
+                result.push_back(values[id]);
+            }
+        }
+        return result;
+    }
+
+    std::string toString() const {
+        std::ostringstream ss;
+        for(std::size_t id = 0; id < nodes_.size(); id++){
+            ss << "%" << id << " = " << describe(nodes_[id]) << std::endl;
+        }
+        ss << "outputs:";
+        for(auto id : outputs_){
+            ss << " %" << id;
+        }
+        return ss.str();
+    }
+
+protected:
+    std::vector<node_type> nodes_;
+    std::vector<std::size_t> outputs_;
+    std::map<std::string, std::size_t> index_;
+
+    static std::string describe(const node_type& n){
+        std::ostringstream ss;
+        ss.precision(std::numeric_limits<double>::max_digits10);
+        ss << plan_op_name(n.op);
+        if(n.op == plan_op::atom){
+            ss << " " << n.name;
+        }
+        for(auto a : n.args){
+            ss << " %" << a;
+        }
+        if(is_bounded_op(n.op)){
+            ss << " " << (n.lbound.sign ? "[" : "(") << n.lbound.value << ","
+               << n.ubound.value << (n.ubound.sign ? "]" : ")");
+        }
+        return ss.str();
+    }
+
+    std::size_t insert(const node_type& n){
+        for(auto a : n.args){
+            if(a >= nodes_.size()){
+                throw std::out_of_range("plan: operand refers to an unknown node");
+            }
+        }
+        std::string key = describe(n);
+        auto it = index_.find(key);
+        if(it != index_.end()){
+            return it->second;
+        }
+        nodes_.push_back(n);
+        index_[key] = nodes_.size() - 1;
+        return nodes_.size() - 1;
+    }
+
+};
+
+template <typename T>
+inline std::ostream& operator<< (std::ostream &os, const plan<T>& p) {
+    os << p.toString();
+    return os;
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_PLAN_HPP
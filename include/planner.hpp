@@ -0,0 +1,262 @@
+#ifndef TIMEDREL_PLANNER_HPP
+#define TIMEDREL_PLANNER_HPP 1
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+
+#include "bound.hpp"
+#include "zone_set.hpp"
+#include "plan.hpp"
+#include "statistics.hpp"
+
+namespace timedrel {
+
+/**
+ *  Rewrites a plan using statistics of its atoms.
+ *
+ *  - Chains of intersections and unions are flattened and rebuilt so that
+ *    the smallest operands are combined first: intersections fold from the
+ *    smallest operand up, unions merge the two smallest operands first.
+ *  - Duration restrictions are pushed down: through unions to every operand,
+ *    through intersections to the concatenations, or else to the smallest
+ *    operand, and nested ones are merged. Over a concatenation they become
+ *    the fused operator.
+ *
+ *  The result denotes the same %zone_set as the original plan.
+ */
+template <class T>
+class planner {
+
+public:
+    typedef plan<T>                               plan_type;
+    typedef typename plan_type::node_type         node_type;
+    typedef typename plan_type::lower_bound_type  lower_bound_type;
+    typedef typename plan_type::upper_bound_type  upper_bound_type;
+    typedef zone_set_statistics<T>                statistics_type;
+    typedef std::map<std::string, statistics_type> statistics_map;
+
+    planner(const plan_type& p, const statistics_map& stats) : in(p), stats(stats) {}
+
+    plan_type optimize(){
+        for(auto id : in.outputs()){
+            out.add_output(build(id, nullptr).id);
+        }
+        return out;
+    }
+
+private:
+
+    struct window {
+        lower_bound_type lbound;
+        upper_bound_type ubound;
+    };
+
+    /* A rebuilt node with its estimated number of zones */
+    struct estimate {
+        std::size_t id;
+        double count;
+
+        bool operator<(const estimate& other) const {
+            return count < other.count or (count == other.count and id < other.id);
+        }
+    };
+
+    const plan_type& in;
+    const statistics_map& stats;
+    plan_type out;
+    std::map<std::pair<std::size_t, std::string>, estimate> memo;
+
+    static std::string key(const window* w){
+        if(w == nullptr){
+            return std::string();
+        }
+        std::ostringstream ss;
+        ss.precision(std::numeric_limits<double>::max_digits10);
+        ss << w->lbound.sign << w->lbound.value << "," << w->ubound.value << w->ubound.sign;
+        return ss.str();
+    }
+
+    static window meet(const window* w, const node_type& n){
+        if(w == nullptr){
+            return window{n.lbound, n.ubound};
+        }
+        return window{lower_bound_type::intersection(w->lbound, n.lbound),
+                      upper_bound_type::intersection(w->ubound, n.ubound)};
+    }
+
+    /* Restricts an already rebuilt node to the window, if any */
+    estimate restrict(estimate e, const window* w, double selectivity){
+        if(w == nullptr){
+            return e;
+        }
+        return estimate{out.bounded(plan_op::duration_restriction, e.id, w->lbound, w->ubound), e.count * selectivity};
+    }
+
+    void flatten(std::size_t id, plan_op op, std::vector<std::size_t>& operands) const {
+        const node_type& n = in.node(id);
+        if(n.op == op){
+            for(auto a : n.args){
+                flatten(a, op, operands);
+            }
+        } else {
+            operands.push_back(id);
+        }
+    }
+
+    estimate build(std::size_t id, const window* w){
+
+        auto k = std::make_pair(id, key(w));
+        auto it = memo.find(k);
+        if(it != memo.end()){
+            return it->second;
+        }
+
+        const node_type& n = in.node(id);
+        estimate result;
+
+        switch(n.op){
+
+        case plan_op::atom: {
+            estimate e{out.atom(n.name), 1e18};
+            double selectivity = 1;
+            auto s = stats.find(n.name);
+            if(s != stats.end()){
+                e.count = s->second.count;
+                if(w != nullptr){
+                    selectivity = s->second.duration_selectivity(w->lbound, w->ubound);
+                }
+            }
+            result = restrict(e, w, selectivity);
+            break;
+        }
+
+        case plan_op::duration_restriction: {
+            window m = meet(w, n);
+            result = build(n.args[0], &m);
+            break;
+        }
+
+        case plan_op::intersection:
+        case plan_op::set_union: {
+            std::vector<std::size_t> operands;
+            flatten(id, n.op, operands);
+
+            std::multiset<estimate> pending;
+            if(n.op == plan_op::intersection and w != nullptr){
+                /*
+                 *  D(A & B) = D(A) & B: restrict concatenations, where the window
+                 *  is fused into the sweep, and otherwise only the smallest operand.
+                 */
+                std::vector<std::size_t> plain;
+                for(auto a : operands){
+                    if(in.node(a).op == plan_op::concatenation or in.node(a).op == plan_op::concatenation_duration_restriction){
+                        pending.insert(build(a, w));
+                    } else {
+                        plain.push_back(a);
+                    }
+                }
+                if(pending.empty()){
+                    auto smallest = std::min_element(plain.begin(), plain.end(), [&](std::size_t a, std::size_t b){
+                        return build(a, nullptr) < build(b, nullptr);
+                    });
+                    pending.insert(build(*smallest, w));
+                    plain.erase(smallest);
+                }
+                for(auto a : plain){
+                    pending.insert(build(a, nullptr));
+                }
+            } else {
+                for(auto a : operands){
+                    pending.insert(build(a, w));
+                }
+            }
+
+            if(n.op == plan_op::intersection){
+                /* Smallest first, each step bounded by the smaller operand */
+                auto first = pending.begin();
+                result = *first;
+                for(auto e = std::next(first); e != pending.end(); e++){
+                    result = estimate{out.binary(plan_op::intersection, result.id, e->id), std::min(result.count, e->count)};
+                }
+            } else {
+                /* Merge the two smallest, as in Huffman coding */
+                while(pending.size() > 1){
+                    estimate a = *pending.begin();
+                    pending.erase(pending.begin());
+                    estimate b = *pending.begin();
+                    pending.erase(pending.begin());
+                    pending.insert(estimate{out.binary(plan_op::set_union, a.id, b.id), a.count + b.count});
+                }
+                result = *pending.begin();
+            }
+            break;
+        }
+
+        case plan_op::concatenation:
+        case plan_op::concatenation_duration_restriction: {
+            estimate a = build(n.args[0], nullptr);
+            estimate b = build(n.args[1], nullptr);
+            estimate c{out.binary(plan_op::concatenation, a.id, b.id), std::max(a.count, b.count)};
+            if(n.op == plan_op::concatenation_duration_restriction){
+                window m = meet(w, n);
+                result = restrict(c, &m, 1);
+            } else {
+                result = restrict(c, w, 1);
+            }
+            break;
+        }
+
+        default: {
+            std::vector<estimate> args;
+            for(auto a : n.args){
+                args.push_back(build(a, nullptr));
+            }
+            estimate e{0, args[0].count};
+            if(is_bounded_op(n.op)){
+                e.id = out.bounded(n.op, args[0].id, n.lbound, n.ubound);
+            } else if(args.size() == 2){
+                e.id = out.binary(n.op, args[0].id, args[1].id);
+            } else {
+                e.id = out.unary(n.op, args[0].id);
+            }
+            result = restrict(e, w, 1);
+            break;
+        }
+        }
+
+        memo[k] = result;
+        return result;
+    }
+};
+
+/**
+ *  @brief  Reorders a plan using statistics of its atoms
+ *  @param  p      A plan
+ *  @param  stats  Statistics of the atoms by name; atoms without statistics are assumed large
+ */
+template <class T>
+plan<T> optimize(const plan<T>& p, const std::map<std::string, zone_set_statistics<T>>& stats){
+    return planner<T>(p, stats).optimize();
+}
+
+/**
+ *  @brief  Reorders a plan for the given match sets of its atoms
+ */
+template <class T>
+plan<T> optimize(const plan<T>& p, const typename plan<T>::atom_map& atoms){
+    std::map<std::string, zone_set_statistics<T>> stats;
+    for(const auto& a : atoms){
+        stats[a.first] = zone_set_statistics<T>::compute(*a.second);
+    }
+    return optimize(p, stats);
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_PLANNER_HPP
@@ -0,0 +1,250 @@
+#ifndef TIMEDREL_RANK_HPP
+#define TIMEDREL_RANK_HPP 1
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#include "bound.hpp"
+#include "zone.hpp"
+#include "zone_set.hpp"
+
+namespace timedrel {
+
+/**
+ *  Dense integer ranks of the distinct endpoint values of some zone sets.
+ *
+ *  Mapping every value to its rank preserves all comparisons between them,
+ *  so an operator whose result only depends on comparing endpoints (and not
+ *  on adding them) can run on ranks. `filter` and `includes` qualify; the
+ *  operators that normalize new zones with `zone::make` do not. Ranking
+ *  costs one sort of the endpoints, which pays off when the sweep compares
+ *  many zones, e.g. with rationals and long active lists.
+ */
+template <class T>
+class rank_domain {
+
+public:
+    typedef T             value_type;
+    typedef std::uint32_t rank_type;
+
+    /* Adds the endpoints of a set, which must outlive `build` */
+    void add(const zone_set<T>& zs){
+        sets.push_back(&zs);
+    }
+
+    /* Ranks the endpoints of the sets added so far */
+    void build(){
+        std::vector<T> all;
+        for(auto zs : sets){
+            all.reserve(all.size() + 6*zs->size());
+            for(const auto& z : *zs){
+                all.push_back(z.get_bmin().value);
+                all.push_back(z.get_bmax().value);
+                all.push_back(z.get_emin().value);
+                all.push_back(z.get_emax().value);
+                all.push_back(z.get_dmin().value);
+                all.push_back(z.get_dmax().value);
+            }
+        }
+        std::vector<std::size_t> order(all.size());
+        for(std::size_t i = 0; i < order.size(); i++){
+            order[i] = i;
+        }
+        /* Positions are sorted rather than values, which may be costly to move */
+        std::sort(order.begin(), order.end(), [&](std::size_t i, std::size_t j){ return all[i] < all[j]; });
+
+        ranks.assign(all.size(), 0);
+        distinct = 0;
+        for(std::size_t k = 0; k < order.size(); k++){
+            if(k == 0 or all[order[k-1]] < all[order[k]]){
+                distinct++;
+            }
+            ranks[order[k]] = static_cast<rank_type>(distinct - 1);
+        }
+        if(distinct > std::numeric_limits<rank_type>::max()){
+            throw std::length_error("rank_domain: too many distinct values");
+        }
+    }
+
+    /* Ranks of the six endpoints of every zone of the k-th set, in `add` order */
+    const rank_type* ranks_of(std::size_t k) const {
+        std::size_t offset = 0;
+        for(std::size_t i = 0; i < k; i++){
+            offset += 6*sets[i]->size();
+        }
+        return ranks.data() + offset;
+    }
+
+    /* Number of distinct values */
+    std::size_t size() const {
+        return distinct;
+    }
+
+private:
+    std::vector<const zone_set<T>*> sets;
+    std::vector<rank_type> ranks;
+    std::size_t distinct = 0;
+};
+
+/*
+ *  A zone with its endpoint values replaced by ranks, and the position of
+ *  the original zone in its set.
+ */
+template <class R>
+struct ranked_zone {
+
+    typedef lower_bound<R> lower_bound_type;
+    typedef upper_bound<R> upper_bound_type;
+
+    lower_bound_type bmin, emin, dmin;
+    upper_bound_type bmax, emax, dmax;
+    std::size_t index;
+
+    /* Same test as `zone::includes` */
+    static bool includes(const ranked_zone& z1, const ranked_zone& z2){
+        return lower_bound_type::includes(z1.bmin, z2.bmin) and
+               upper_bound_type::includes(z1.bmax, z2.bmax) and
+               lower_bound_type::includes(z1.emin, z2.emin) and
+               upper_bound_type::includes(z1.emax, z2.emax) and
+               lower_bound_type::includes(z1.dmin, z2.dmin) and
+               upper_bound_type::includes(z1.dmax, z2.dmax);
+    }
+};
+
+namespace detail {
+
+template <class T>
+std::vector< ranked_zone<std::uint32_t> > to_ranks(const zone_set<T>& zs, const rank_domain<T>& domain, std::size_t k){
+
+    typedef ranked_zone<std::uint32_t> ranked_type;
+    typedef typename ranked_type::lower_bound_type lower_bound_type;
+    typedef typename ranked_type::upper_bound_type upper_bound_type;
+
+    std::vector<ranked_type> result;
+    result.reserve(zs.size());
+    const std::uint32_t* r = domain.ranks_of(k);
+    std::size_t i = 0;
+    for(const auto& z : zs){
+        result.push_back(ranked_type{
+            lower_bound_type(r[0], z.get_bmin().sign),
+            lower_bound_type(r[2], z.get_emin().sign),
+            lower_bound_type(r[4], z.get_dmin().sign),
+            upper_bound_type(r[1], z.get_bmax().sign),
+            upper_bound_type(r[3], z.get_emax().sign),
+            upper_bound_type(r[5], z.get_dmax().sign),
+            i++});
+        r += 6;
+    }
+    return result;
+}
+
+} // namespace detail
+
+/**
+ *  @brief  Same result as `zone_set::filter`, with the sweep run on ranks
+ *  @param  zs  A %zone_set sorted by bmin
+ *
+ *  The kept zones are copied from `zs`, so values are never converted.
+ */
+template <class T>
+zone_set<T> filter_ranked(const zone_set<T>& zs){
+
+    typedef ranked_zone<std::uint32_t> ranked_type;
+
+    rank_domain<T> domain;
+    domain.add(zs);
+    domain.build();
+    std::vector<ranked_type> ranked = detail::to_ranks(zs, domain, 0);
+
+    std::vector<ranked_type> active, active_temp, kept;
+    for(const auto& z1 : ranked){
+
+        bool already_included = std::any_of(active.begin(), active.end(), [&](const ranked_type& z2){return ranked_type::includes(z2, z1);});
+
+        if(!already_included){
+
+            active.erase( std::remove_if(active.begin(), active.end(), [&](const ranked_type& z2){return ranked_type::includes(z1, z2);}), active.end());
+            active.push_back(z1);
+
+            active_temp.clear();
+            for(const auto& z2 : active){
+                if( z2.bmax < z1.bmin){
+                    kept.push_back(z2);
+                } else {
+                    active_temp.push_back(z2);
+                }
+            }
+            std::swap(active, active_temp);
+        }
+    }
+    kept.insert(kept.end(), active.begin(), active.end());
+
+    std::sort(kept.begin(), kept.end(), [](const ranked_type& z1, const ranked_type& z2){ return z1.bmin < z2.bmin; });
+
+    zone_set<T> result;
+    auto first = zs.cbegin();
+    for(const auto& z : kept){
+        result.push_back(*(first + z.index));
+    }
+    return result;
+}
+
+/**
+ *  @brief  Same result as `zone_set::includes`, with the sweep run on ranks
+ *  @param  zs1  A %zone_set sorted by bmin
+ *  @param  zs2  A %zone_set sorted by bmin
+ */
+template <class T>
+bool includes_ranked(const zone_set<T>& zs1, const zone_set<T>& zs2){
+
+    typedef ranked_zone<std::uint32_t> ranked_type;
+
+    if(zs2.empty()){
+        return true;
+    } else if(zs1.empty()){
+        return false;
+    }
+
+    rank_domain<T> domain;
+    domain.add(zs1);
+    domain.add(zs2);
+    domain.build();
+    std::vector<ranked_type> ranked1 = detail::to_ranks(zs1, domain, 0);
+    std::vector<ranked_type> ranked2 = detail::to_ranks(zs2, domain, 1);
+
+    std::vector<ranked_type> act_1;
+
+    auto it1 = ranked1.cbegin();
+    auto it2 = ranked2.cbegin();
+
+    auto covered = [&](const ranked_type& z2){
+        act_1.erase( std::remove_if(act_1.begin(), act_1.end(), [&](const ranked_type& z1){return z1.bmax < z2.bmin;}), act_1.end());
+        return std::any_of(act_1.begin(), act_1.end(), [&](const ranked_type& z1){return ranked_type::includes(z1, z2);});
+    };
+
+    while(it1 != ranked1.cend() and it2 != ranked2.cend()) {
+        if (!(it2->bmin < it1->bmin)){
+            act_1.push_back(*it1);
+            it1++;
+        } else {
+            if(!covered(*it2)){
+                return false;
+            }
+            it2++;
+        }
+    }
+    while (it2 != ranked2.cend()) {
+        if(!covered(*it2)){
+            return false;
+        }
+        it2++;
+    }
+    return true;
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_RANK_HPP
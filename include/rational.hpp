@@ -0,0 +1,407 @@
+#ifndef TIMEDREL_RATIONAL_HPP
+#define TIMEDREL_RATIONAL_HPP 1
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include <gmpxx.h>
+
+#ifndef __SIZEOF_INT128__
+#error "timedrel::rational needs a compiler with 128-bit integers"
+#endif
+
+namespace timedrel {
+
+/**
+ *  Exact rational number that keeps its numerator and denominator in two
+ *  64-bit integers and only falls back to GMP when they do not fit.
+ *
+ *  Values are always in lowest terms with a positive denominator, and a
+ *  value that fits in 64 bits is never stored in GMP form, so equality is
+ *  a comparison of the representations. Operations on small values use
+ *  128-bit intermediates and do not allocate; typical timestamps (integers
+ *  or fractions with small denominators) stay on that path.
+ *
+ *  Like `double`, the type has +/-infinity and NaN, with the IEEE rules for
+ *  arithmetic and comparisons on them, so unbounded endpoints stay on the
+ *  small path as well. Drop-in for `mpq_class` as the value type of bounds,
+ *  zones and zone sets.
+ */
+class rational {
+
+public:
+    rational() : num(0), den(1) {}
+
+    rational(int v) : num(v), den(1) {}
+    rational(long v) : num(v), den(1) {}
+    rational(long long v) : num(v), den(1) {}
+
+    rational(long long n, long long d) : num(0), den(1) {
+        if(d == 0){
+            throw std::domain_error("rational: zero denominator");
+        }
+        assign(static_cast<wide>(n), static_cast<wide>(d));
+    }
+
+    /* Exact value of `v` */
+    rational(double v) : num(0), den(1) {
+        if(std::isnan(v) or std::isinf(v)){
+            *this = special(v);
+        } else if(v == std::trunc(v) and std::fabs(v) < 4611686018427387904.0){
+            num = static_cast<std::int64_t>(v);
+        } else {
+            assign(mpq_class(v));
+        }
+    }
+
+    rational(const mpq_class& q) : num(0), den(1) {
+        assign(q);
+    }
+
+    /* Parses "n", "n/d", a decimal such as "-1.25", "inf", "-inf" or "nan" */
+    explicit rational(const std::string& s) : num(0), den(1) {
+        if(!parse(s, *this)){
+            throw std::invalid_argument("rational: invalid number '" + s + "'");
+        }
+    }
+
+    rational(const rational& other) : num(other.num), den(other.den), big(other.big ? new mpq_class(*other.big) : nullptr) {}
+    rational(rational&& other) = default;
+
+    rational& operator=(const rational& other){
+        if(this != &other){
+            num = other.num;
+            den = other.den;
+            big.reset(other.big ? new mpq_class(*other.big) : nullptr);
+        }
+        return *this;
+    }
+    rational& operator=(rational&& other) = default;
+
+    /* Whether the value is held in 64-bit integers */
+    bool is_small() const {
+        return !big;
+    }
+
+    /* Whether the value is an infinity or NaN */
+    bool is_special() const {
+        return den == 0;
+    }
+
+    /*
+     *  Numerator and denominator when `is_small()`; the denominator of the
+     *  special values is 0 and their numerator is 1, -1 or 0 for NaN
+     */
+    std::int64_t small_numerator() const {
+        return num;
+    }
+    std::int64_t small_denominator() const {
+        return den;
+    }
+
+    mpq_class get_mpq() const {
+        if(is_special()){
+            throw std::domain_error("rational: no rational value for " + get_str());
+        }
+        if(big){
+            return *big;
+        }
+        mpq_class q;
+        set_mpz(q.get_num(), num);
+        set_mpz(q.get_den(), den);
+        return q;
+    }
+
+    double get_d() const {
+        return big ? big->get_d() : static_cast<double>(num) / static_cast<double>(den);
+    }
+
+    explicit operator double() const {
+        return get_d();
+    }
+
+    std::string get_str() const {
+        if(big){
+            return big->get_str();
+        }
+        if(is_special()){
+            return num == 0 ? "nan" : (num > 0 ? "inf" : "-inf");
+        }
+        return den == 1 ? std::to_string(num) : std::to_string(num) + "/" + std::to_string(den);
+    }
+
+    friend rational operator+(const rational& a, const rational& b){
+        if(a.is_special() or b.is_special()){
+            return special(a.get_d() + b.get_d());
+        }
+        if(a.is_small() and b.is_small()){
+            std::int64_t r;
+            if(a.den == 1 and b.den == 1 and !__builtin_add_overflow(a.num, b.num, &r)){
+                return rational(static_cast<long long>(r));
+            }
+            return make(static_cast<wide>(a.num) * b.den + static_cast<wide>(b.num) * a.den,
+                        static_cast<wide>(a.den) * b.den);
+        }
+        return rational(a.get_mpq() + b.get_mpq());
+    }
+
+    friend rational operator-(const rational& a, const rational& b){
+        if(a.is_special() or b.is_special()){
+            return special(a.get_d() - b.get_d());
+        }
+        if(a.is_small() and b.is_small()){
+            std::int64_t r;
+            if(a.den == 1 and b.den == 1 and !__builtin_sub_overflow(a.num, b.num, &r)){
+                return rational(static_cast<long long>(r));
+            }
+            return make(static_cast<wide>(a.num) * b.den - static_cast<wide>(b.num) * a.den,
+                        static_cast<wide>(a.den) * b.den);
+        }
+        return rational(a.get_mpq() - b.get_mpq());
+    }
+
+    friend rational operator*(const rational& a, const rational& b){
+        if(a.is_special() or b.is_special()){
+            return special(a.get_d() * b.get_d());
+        }
+        if(a.is_small() and b.is_small()){
+            return make(static_cast<wide>(a.num) * b.num, static_cast<wide>(a.den) * b.den);
+        }
+        return rational(mpq_class(a.get_mpq() * b.get_mpq()));
+    }
+
+    friend rational operator/(const rational& a, const rational& b){
+        if(b == rational()){
+            throw std::domain_error("rational: division by zero");
+        }
+        if(a.is_special() or b.is_special()){
+            return special(a.get_d() / b.get_d());
+        }
+        if(a.is_small() and b.is_small()){
+            return make(static_cast<wide>(a.num) * b.den, static_cast<wide>(a.den) * b.num);
+        }
+        return rational(mpq_class(a.get_mpq() / b.get_mpq()));
+    }
+
+    rational operator-() const {
+        return rational() - *this;
+    }
+
+    rational& operator+=(const rational& b){ return *this = *this + b; }
+    rational& operator-=(const rational& b){ return *this = *this - b; }
+    rational& operator*=(const rational& b){ return *this = *this * b; }
+    rational& operator/=(const rational& b){ return *this = *this / b; }
+
+    friend bool operator==(const rational& a, const rational& b){
+        if(a.is_small() and b.is_small()){
+            return a.num == b.num and a.den == b.den and !(a.den == 0 and a.num == 0);
+        }
+        return a.is_small() == b.is_small() and *a.big == *b.big;
+    }
+
+    friend bool operator<(const rational& a, const rational& b){
+        if(a.is_special() or b.is_special()){
+            return a.get_d() < b.get_d() or (a.get_d() == b.get_d() and a.order() < b.order());
+        }
+        if(a.is_small() and b.is_small()){
+            if(a.den == b.den){
+                return a.num < b.num;
+            }
+            return static_cast<wide>(a.num) * b.den < static_cast<wide>(b.num) * a.den;
+        }
+        return a.get_mpq() < b.get_mpq();
+    }
+
+    friend bool operator!=(const rational& a, const rational& b){ return !(a == b); }
+    friend bool operator>(const rational& a, const rational& b){ return b < a; }
+    friend bool operator<=(const rational& a, const rational& b){ return a < b or a == b; }
+    friend bool operator>=(const rational& a, const rational& b){ return b < a or a == b; }
+
+    friend std::ostream& operator<<(std::ostream& os, const rational& r){
+        return os << r.get_str();
+    }
+
+    friend std::istream& operator>>(std::istream& is, rational& r){
+        std::string s;
+        if(is >> s and !parse(s, r)){
+            is.setstate(std::ios::failbit);
+        }
+        return is;
+    }
+
+    static rational infinity(){
+        return special(std::numeric_limits<double>::infinity());
+    }
+
+    static rational quiet_nan(){
+        return special(std::numeric_limits<double>::quiet_NaN());
+    }
+
+private:
+    typedef __int128 wide;
+    typedef unsigned __int128 uwide;
+
+    /* The value is num/den unless `big` is set */
+    std::int64_t num;
+    std::int64_t den;
+    std::unique_ptr<mpq_class> big;
+
+    static uwide gcd(uwide a, uwide b){
+        while(b != 0){
+            uwide t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    /*
+     *  Result of an operation involving a special value, computed in double:
+     *  an infinity, NaN, or a finite value that can only be 0 (x / inf)
+     */
+    static rational special(double v){
+        rational r;
+        if(std::isnan(v)){
+            r.den = 0;
+        } else if(std::isinf(v)){
+            r.num = (v > 0) ? 1 : -1;
+            r.den = 0;
+        }
+        return r;
+    }
+
+    /*
+     *  Tie-break for `<` when the doubles compare equal: only an infinity and
+     *  a finite value beyond the double range can get there
+     */
+    int order() const {
+        return is_special() ? static_cast<int>(num) * 2 : 0;
+    }
+
+    static rational make(wide n, wide d){
+        rational r;
+        r.assign(n, d);
+        return r;
+    }
+
+    static bool fits(wide v){
+        return v >= std::numeric_limits<std::int64_t>::min() and v <= std::numeric_limits<std::int64_t>::max();
+    }
+
+    static void set_mpz(mpz_class& z, wide v){
+        bool negative = v < 0;
+        uwide u = negative ? -static_cast<uwide>(v) : static_cast<uwide>(v);
+        z = static_cast<unsigned long>(u >> 64);
+        z <<= 64;
+        z += mpz_class(static_cast<unsigned long>(u & 0xffffffffffffffffULL));
+        if(negative){
+            z = -z;
+        }
+    }
+
+    /* Sets the value to n/d, d != 0 */
+    void assign(wide n, wide d){
+        if(d < 0){
+            n = -n;
+            d = -d;
+        }
+        uwide g = gcd(n < 0 ? -static_cast<uwide>(n) : static_cast<uwide>(n), static_cast<uwide>(d));
+        if(g > 1){
+            n /= static_cast<wide>(g);
+            d /= static_cast<wide>(g);
+        }
+        if(fits(n) and fits(d)){
+            num = static_cast<std::int64_t>(n);
+            den = static_cast<std::int64_t>(d);
+            big.reset();
+        } else {
+            mpq_class q;
+            set_mpz(q.get_num(), n);
+            set_mpz(q.get_den(), d);
+            big.reset(new mpq_class(q));
+        }
+    }
+
+    void assign(mpq_class q){
+        q.canonicalize();
+        if(q.get_num().fits_slong_p() and q.get_den().fits_slong_p() and sizeof(long) == sizeof(std::int64_t)){
+            num = q.get_num().get_si();
+            den = q.get_den().get_si();
+            big.reset();
+        } else {
+            big.reset(new mpq_class(q));
+        }
+    }
+
+    static bool parse(const std::string& s, rational& r){
+        if(s == "inf" or s == "+inf" or s == "infinity" or s == "-inf" or s == "-infinity" or s == "nan"){
+            r = special(s == "nan" ? std::nan("") : (s[0] == '-' ? -HUGE_VAL : HUGE_VAL));
+            return true;
+        }
+        std::size_t point = s.find('.');
+        if(point == std::string::npos){
+            mpq_class q;
+            if(s.empty() or q.set_str(s, 10) != 0){
+                return false;
+            }
+            r.assign(q);
+            return true;
+        }
+        /* Decimal: digits without the point over the matching power of ten */
+        std::string digits = s.substr(0, point) + s.substr(point + 1);
+        if(digits.empty() or digits == "-" or digits == "+" or digits.find_first_of(".eE/") != std::string::npos){
+            return false;
+        }
+        mpz_class n, d;
+        if(n.set_str(digits[0] == '+' ? digits.substr(1) : digits, 10) != 0){
+            return false;
+        }
+        mpz_ui_pow_ui(d.get_mpz_t(), 10, s.size() - point - 1);
+        r.assign(mpq_class(n, d));
+        return true;
+    }
+};
+
+} // namespace timedrel
+
+namespace std {
+
+template <>
+class numeric_limits<timedrel::rational> {
+public:
+    static const bool is_specialized = true;
+    static const bool is_signed = true;
+    static const bool is_integer = false;
+    static const bool is_exact = true;
+    static const bool has_infinity = true;
+    static const bool has_quiet_NaN = true;
+    static const bool has_signaling_NaN = false;
+    static const bool is_bounded = false;
+
+    /* Largest value that stays on the 64-bit path */
+    static timedrel::rational max(){
+        return timedrel::rational(std::numeric_limits<long long>::max());
+    }
+    static timedrel::rational lowest(){
+        return -max();
+    }
+    static timedrel::rational min(){
+        return timedrel::rational(1LL, std::numeric_limits<long long>::max());
+    }
+    static timedrel::rational infinity(){
+        return timedrel::rational::infinity();
+    }
+    static timedrel::rational quiet_NaN(){
+        return timedrel::rational::quiet_nan();
+    }
+};
+
+} // namespace std
+
+#endif // TIMEDREL_RATIONAL_HPP
@@ -0,0 +1,402 @@
+#ifndef TIMEDREL_SERIALIZATION_HPP
+#define TIMEDREL_SERIALIZATION_HPP 1
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "zone.hpp"
+#include "zone_set.hpp"
+#include "block_index.hpp"
+
+namespace timedrel {
+
+/*
+ *  Binary zone_set file, version 1. All fields are in native byte order;
+ *  `byte_order` lets a reader on another architecture reject the file.
+ *
+ *    header     64 bytes, see `zone_set_file_header`
+ *    values     count x 6 values (bmin, bmax, emin, emax, dmin, dmax)
+ *    signs      count bytes, bit k holds the strictness flag of value k
+ *    index      block_count x `block_summary<T>` (optional), 8-byte aligned
+ *
+ *  The values start at offset 64 so a memory-mapped file can be read in place.
+ */
+struct zone_set_file_header {
+    char          magic[4];
+    std::uint16_t version;
+    std::uint16_t byte_order;
+    std::uint8_t  value_kind;
+    std::uint8_t  value_size;
+    std::uint8_t  flags;
+    std::uint8_t  reserved0;
+    std::uint32_t block_size;
+    std::uint64_t count;
+    std::uint64_t values_offset;
+    std::uint64_t signs_offset;
+    std::uint64_t index_offset;
+    std::uint64_t block_count;
+    std::uint64_t reserved1;
+};
+
+static_assert(sizeof(zone_set_file_header) == 64, "zone_set file header must be 64 bytes");
+
+namespace serialization {
+
+static const char          magic[4]      = {'R', 'T', 'Z', 'S'};
+static const std::uint16_t version       = 1;
+static const std::uint16_t byte_order    = 0x0102;
+
+static const std::uint8_t  sorted_by_bmin  = 1;
+static const std::uint8_t  has_block_index = 2;
+
+enum value_kind : std::uint8_t { signed_integer = 1, unsigned_integer = 2, floating_point = 3 };
+
+template <class T>
+inline std::uint8_t kind_of(){
+    static_assert(std::is_arithmetic<T>::value, "binary zone_set files need fixed-width values");
+    return std::is_floating_point<T>::value ? floating_point :
+           std::is_signed<T>::value ? signed_integer : unsigned_integer;
+}
+
+inline std::uint64_t align8(std::uint64_t offset){
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+template <class Zone>
+inline std::uint8_t pack_signs(const Zone& z){
+    return std::uint8_t(
+        (z.get_bmin().sign ? 1 : 0)  | (z.get_bmax().sign ? 2 : 0)  |
+        (z.get_emin().sign ? 4 : 0)  | (z.get_emax().sign ? 8 : 0)  |
+        (z.get_dmin().sign ? 16 : 0) | (z.get_dmax().sign ? 32 : 0));
+}
+
+template <class T>
+inline zone<T> unpack_zone(const T* v, std::uint8_t s){
+    typedef typename zone<T>::lower_bound_type lower_bound_type;
+    typedef typename zone<T>::upper_bound_type upper_bound_type;
+    return zone<T>::make_canonical(
+        lower_bound_type(v[0], (s & 1) != 0),  upper_bound_type(v[1], (s & 2) != 0),
+        lower_bound_type(v[2], (s & 4) != 0),  upper_bound_type(v[3], (s & 8) != 0),
+        lower_bound_type(v[4], (s & 16) != 0), upper_bound_type(v[5], (s & 32) != 0));
+}
+
+/* Whether `count` items of `size` bytes from `offset` lie within the file, without overflow */
+inline bool fits(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::uint64_t file_size){
+    return offset <= file_size and count <= (file_size - offset) / size;
+}
+
+template <class T>
+inline void check_header(const zone_set_file_header& h, std::uint64_t file_size, const std::string& path){
+    if(std::memcmp(h.magic, magic, 4) != 0){
+        throw std::runtime_error(path + ": not a zone_set file");
+    }
+    if(h.version != version){
+        throw std::runtime_error(path + ": unsupported zone_set file version " + std::to_string(h.version));
+    }
+    if(h.byte_order != byte_order){
+        throw std::runtime_error(path + ": zone_set file has a different byte order");
+    }
+    if(h.value_kind != kind_of<T>() or h.value_size != sizeof(T)){
+        throw std::runtime_error(path + ": zone_set file holds a different value type");
+    }
+    if(!fits(h.values_offset, h.count, 6 * sizeof(T), file_size) or
+       !fits(h.signs_offset, h.count, 1, file_size) or
+       !fits(h.index_offset, h.block_count, sizeof(block_summary<T>), file_size)){
+        throw std::runtime_error(path + ": truncated zone_set file");
+    }
+    if(h.values_offset % alignof(T) != 0 or
+       (h.block_count != 0 and h.index_offset % alignof(block_summary<T>) != 0)){
+        throw std::runtime_error(path + ": misaligned zone_set file");
+    }
+}
+
+inline std::runtime_error io_error(const std::string& what, const std::string& path){
+    return std::runtime_error(path + ": " + what + " failed: " + std::strerror(errno));
+}
+
+/* Rebuilds on a loaded set the block index that `save` wrote, if the set is sorted */
+template <class T>
+inline void restore_block_index(zone_set<T>& zs, bool sorted, std::size_t block_size, std::size_t block_count){
+    if(sorted and block_size != 0 and block_count != 0 and zs.is_sorted_by_bmin()){
+        zs.build_block_index(block_size);
+    }
+}
+
+} // namespace serialization
+
+/**
+ *  @brief  Writes a zone set to a binary file
+ *  @param  zs          A %zone_set with arithmetic values.
+ *  @param  path        Output file.
+ *  @param  block_size  Zones per block of the optional block index (0 writes no index).
+ *
+ *  Values are stored exactly. The sortedness flag is set if the zones are sorted by bmin.
+ */
+template <class T, class Container>
+void save(const zone_set<T, Container>& zs, const std::string& path, std::size_t block_size = 64){
+
+    namespace io = serialization;
+
+    std::vector< block_summary<T> > index = make_block_summaries<T>(zs.cbegin(), zs.cend(), block_size);
+
+    zone_set_file_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, io::magic, 4);
+    h.version       = io::version;
+    h.byte_order    = io::byte_order;
+    h.value_kind    = io::kind_of<T>();
+    h.value_size    = sizeof(T);
+    h.flags         = (zs.is_sorted_by_bmin() ? io::sorted_by_bmin : 0) |
+                      (index.empty() ? 0 : io::has_block_index);
+    h.block_size    = index.empty() ? 0 : static_cast<std::uint32_t>(block_size);
+    h.count         = zs.size();
+    h.values_offset = sizeof(zone_set_file_header);
+    h.signs_offset  = h.values_offset + h.count * 6 * sizeof(T);
+    h.index_offset  = io::align8(h.signs_offset + h.count);
+    h.block_count   = index.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out){
+        throw io::io_error("open", path);
+    }
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    const std::size_t chunk = 4096;
+    std::vector<T> values;
+    std::vector<std::uint8_t> signs;
+    values.reserve(6 * chunk);
+    signs.reserve(zs.size());
+
+    for(auto it = zs.cbegin(); it != zs.cend(); it++){
+        values.push_back(it->get_bmin().value);
+        values.push_back(it->get_bmax().value);
+        values.push_back(it->get_emin().value);
+        values.push_back(it->get_emax().value);
+        values.push_back(it->get_dmin().value);
+        values.push_back(it->get_dmax().value);
+        signs.push_back(io::pack_signs(*it));
+        if(values.size() == 6 * chunk){
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+            values.clear();
+        }
+    }
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    out.write(reinterpret_cast<const char*>(signs.data()), signs.size());
+
+    const char padding[8] = {0};
+    out.write(padding, h.index_offset - (h.signs_offset + h.count));
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(block_summary<T>));
+
+    if(!out){
+        throw io::io_error("write", path);
+    }
+}
+
+/**
+ *  Read-only memory mapping of a binary zone_set file.
+ *
+ *  Opening only maps the file; zones are decoded on access, so pages are read
+ *  from disk on demand. The mapping stays valid for the lifetime of the object.
+ */
+template <class T>
+class mapped_zone_set {
+
+public:
+    typedef T                   value_type;
+    typedef zone<T>             zone_type;
+    typedef zone_set<T>         zone_set_type;
+    typedef std::size_t         size_type;
+
+    explicit mapped_zone_set(const std::string& path) : path(path) {
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            throw serialization::io_error("open", path);
+        }
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            ::close(fd);
+            throw serialization::io_error("stat", path);
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if(length < sizeof(zone_set_file_header)){
+            ::close(fd);
+            throw std::runtime_error(path + ": not a zone_set file");
+        }
+
+        address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(address == MAP_FAILED){
+            address = nullptr;
+            throw serialization::io_error("mmap", path);
+        }
+
+        std::memcpy(&header, address, sizeof(header));
+        try {
+            serialization::check_header<T>(header, length, path);
+        } catch(...) {
+            ::munmap(address, length);
+            throw;
+        }
+    }
+
+    mapped_zone_set(const mapped_zone_set&) = delete;
+    mapped_zone_set& operator=(const mapped_zone_set&) = delete;
+
+    mapped_zone_set(mapped_zone_set&& other) noexcept :
+        path(std::move(other.path)), address(other.address), length(other.length), header(other.header) {
+        other.address = nullptr;
+        other.length = 0;
+    }
+
+    ~mapped_zone_set(){
+        if(address != nullptr){
+            ::munmap(address, length);
+        }
+    }
+
+    size_type size() const {
+        return header.count;
+    }
+    bool empty() const {
+        return header.count == 0;
+    }
+    bool is_sorted_by_bmin() const {
+        return (header.flags & serialization::sorted_by_bmin) != 0;
+    }
+    size_type block_size() const {
+        return header.block_size;
+    }
+    size_type block_count() const {
+        return header.block_count;
+    }
+
+    zone_type operator[](size_type i) const {
+        return serialization::unpack_zone<T>(values() + 6*i, signs()[i]);
+    }
+
+    zone_type at(size_type i) const {
+        if(i >= size()){
+            throw std::out_of_range(path + ": zone index out of range");
+        }
+        return (*this)[i];
+    }
+
+    const block_summary<T>& block(size_type k) const {
+        return reinterpret_cast<const block_summary<T>*>(bytes() + header.index_offset)[k];
+    }
+
+    /*
+     *  Decodes the zones [first, last) into an in-memory zone set.
+     */
+    zone_set_type slice(size_type first, size_type last) const {
+        zone_set_type result;
+        last = std::min(last, size());
+        result.reserve(last > first ? last - first : 0);
+        for(size_type i = first; i < last; i++){
+            result.push_back((*this)[i]);
+        }
+        return result;
+    }
+
+    zone_set_type to_zone_set() const {
+        return slice(0, size());
+    }
+
+    /*
+     *  Tells the kernel the whole file will be read front to back.
+     */
+    void advise_sequential() const {
+        ::madvise(address, length, MADV_SEQUENTIAL);
+    }
+
+private:
+    std::string path;
+    void* address = nullptr;
+    std::size_t length = 0;
+    zone_set_file_header header;
+
+    const char* bytes() const {
+        return static_cast<const char*>(address);
+    }
+    const T* values() const {
+        return reinterpret_cast<const T*>(bytes() + header.values_offset);
+    }
+    const std::uint8_t* signs() const {
+        return reinterpret_cast<const std::uint8_t*>(bytes() + header.signs_offset);
+    }
+};
+
+/**
+ *  @brief  Reads a binary zone_set file into memory
+ *  @param  path      Input file.
+ *  @param  use_mmap  Map the file and decode in place instead of buffered reads.
+ *  @return %zone_set with the stored zones, in stored order
+ *
+ *  Every zone is decoded either way; `mapped_zone_set` gives access to a
+ *  file without decoding it. If the file holds a sorted set with a block
+ *  index, the result gets the same index back (see `build_block_index`).
+ */
+template <class T>
+zone_set<T> load(const std::string& path, bool use_mmap = false){
+
+    namespace io = serialization;
+
+    if(use_mmap){
+        mapped_zone_set<T> mapped(path);
+        mapped.advise_sequential();
+        zone_set<T> result = mapped.to_zone_set();
+        io::restore_block_index(result, mapped.is_sorted_by_bmin(), mapped.block_size(), mapped.block_count());
+        return result;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        throw io::io_error("open", path);
+    }
+    in.seekg(0, std::ios::end);
+    std::uint64_t file_size = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0, std::ios::beg);
+
+    zone_set_file_header h;
+    if(file_size < sizeof(h) or !in.read(reinterpret_cast<char*>(&h), sizeof(h))){
+        throw std::runtime_error(path + ": not a zone_set file");
+    }
+    io::check_header<T>(h, file_size, path);
+
+    std::vector<T> values(h.count * 6);
+    std::vector<std::uint8_t> signs(h.count);
+
+    in.seekg(h.values_offset);
+    in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+    in.seekg(h.signs_offset);
+    in.read(reinterpret_cast<char*>(signs.data()), signs.size());
+    if(!in){
+        throw io::io_error("read", path);
+    }
+
+    zone_set<T> result;
+    result.reserve(h.count);
+    for(std::size_t i = 0; i < h.count; i++){
+        result.push_back(io::unpack_zone<T>(values.data() + 6*i, signs[i]));
+    }
+    io::restore_block_index(result, (h.flags & io::sorted_by_bmin) != 0, h.block_size, h.block_count);
+    return result;
+}
+
+} // namespace timedrel
+
+#endif // TIMEDREL_SERIALIZATION_HPP
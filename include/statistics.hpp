@@ -0,0 +1,153 @@
+#ifndef TIMEDREL_STATISTICS_HPP
+#define TIMEDREL_STATISTICS_HPP 1
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include <gmpxx.h>
+
+#include "bound.hpp"
+#include "zone.hpp"
+#include "zone_set.hpp"
+
+namespace timedrel {
+
+namespace detail {
+
+template <class T>
+inline double to_double(const T& v){
+    return static_cast<double>(v);
+}
+
+inline double to_double(const mpq_class& v){
+    return v.get_d();
+}
+
+} // namespace detail
+
+/**
+ *  Cheap summary of a %zone_set used to estimate the cost of operations.
+ *
+ *  Unbounded endpoints are ignored when measuring extents, so the figures
+ *  describe the finite part of the set.
+ */
+template <class T>
+struct zone_set_statistics {
+
+    typedef T value_type;
+
+    /* Number of zones */
+    std::size_t count = 0;
+
+    /* Smallest finite bmin and largest finite emax */
+    double begin = 0;
+    double end = 0;
+
+    /* Mean number of zones active at a time in a sweep by bmin */
+    double average_active = 0;
+
+    /* Smallest dmin over the set */
+    double min_duration = 0;
+
+    /* Histogram of dmax over [0, bins * duration_bin_width), the last bin also counts larger and unbounded ones */
+    double duration_bin_width = 0;
+    std::vector<std::size_t> duration_histogram;
+
+    double span() const {
+        return end - begin;
+    }
+
+    /**
+     *  @brief  Estimated fraction of zones kept by a duration restriction
+     *  @param  dmin  Lower bound of the duration window
+     *  @param  dmax  Upper bound of the duration window
+     */
+    double duration_selectivity(const lower_bound<T>& dmin, const upper_bound<T>& dmax) const {
+
+        if(count == 0 or detail::to_double(dmax.value) < min_duration){
+            return 0;
+        }
+        if(duration_histogram.empty() or duration_bin_width <= 0){
+            return 1;
+        }
+
+        double lo = detail::to_double(dmin.value);
+        std::size_t kept = 0;
+        for(std::size_t k = 0; k < duration_histogram.size(); k++){
+            if(k + 1 == duration_histogram.size() or (k + 1) * duration_bin_width >= lo){
+                kept += duration_histogram[k];
+            }
+        }
+        return double(kept) / count;
+    }
+
+    /**
+     *  @brief  Computes the statistics of a %zone_set in one pass
+     *  @param  zs    A %zone_set
+     *  @param  bins  Number of bins of the duration histogram
+     */
+    static zone_set_statistics compute(const zone_set<T>& zs, std::size_t bins = 16){
+
+        const double infinity = detail::to_double(bound<T>::infinity());
+
+        zone_set_statistics result;
+        result.count = zs.size();
+        if(zs.empty()){
+            return result;
+        }
+
+        bool seen = false;
+        double first_bmin = 0, last_bmin = 0, extent = 0, max_dmax = 0;
+        result.min_duration = detail::to_double(zs.cbegin()->get_dmin().value);
+
+        for(const auto& z : zs){
+            double bmin = detail::to_double(z.get_bmin().value);
+            double bmax = detail::to_double(z.get_bmax().value);
+            double emax = detail::to_double(z.get_emax().value);
+            double dmin = detail::to_double(z.get_dmin().value);
+            double dmax = detail::to_double(z.get_dmax().value);
+
+            if(bmin > -infinity and !seen){
+                result.begin = result.end = first_bmin = last_bmin = bmin;
+                seen = true;
+            }
+            if(bmin > -infinity){
+                result.begin = std::min(result.begin, bmin);
+                first_bmin = std::min(first_bmin, bmin);
+                last_bmin = std::max(last_bmin, bmin);
+            }
+            if(emax < infinity){
+                result.end = std::max(result.end, emax);
+            }
+            if(bmin > -infinity and bmax < infinity){
+                extent += bmax - bmin;
+            }
+            if(dmax < infinity){
+                max_dmax = std::max(max_dmax, dmax);
+            }
+            result.min_duration = std::min(result.min_duration, dmin);
+        }
+
+        double sweep = last_bmin - first_bmin;
+        result.average_active = (sweep > 0) ? 1 + extent / sweep : double(result.count);
+
+        if(bins > 0){
+            result.duration_bin_width = (bins > 1 and max_dmax > 0) ? max_dmax / (bins - 1) : 0;
+            result.duration_histogram.assign(bins, 0);
+            for(const auto& z : zs){
+                double dmax = detail::to_double(z.get_dmax().value);
+                std::size_t k = bins - 1;
+                if(dmax < infinity and result.duration_bin_width > 0){
+                    k = std::min(k, static_cast<std::size_t>(std::max(0.0, dmax) / result.duration_bin_width));
+                }
+                result.duration_histogram[k]++;
+            }
+        }
+        return result;
+    }
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_STATISTICS_HPP
@@ -0,0 +1,336 @@
+#ifndef TIMEDREL_TRE_PARSER_HPP
+#define TIMEDREL_TRE_PARSER_HPP 1
+
+#include <map>
+#include <mutex>
+#include <cctype>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#include <gmpxx.h>
+
+#include "plan.hpp"
+
+namespace timedrel {
+
+/*
+ *  Text syntax of timed regular expressions, from loosest to tightest binding:
+ *
+ *    E | F                 union
+ *    E & F                 intersection
+ *    E ; F                 concatenation
+ *    !E                    complementation
+ *    E+                    transitive closure (one or more repetitions)
+ *    E%[a,b]  <E>_[a,b]    duration restriction
+ *    diamond_meets[a,b](E), ..., box_finished_by[a,b](E)
+ *                          modalities of the logic of time periods
+ *    name  (E)             atoms and grouping
+ *
+ *  Intervals use '[' / ']' for closed and '(' / ')' for open endpoints,
+ *  e.g. (0,5]; `inf` stands for an unbounded upper endpoint. Kleene star
+ *  `E*` is rejected: it would also match the empty period, which has no
+ *  zone set here, so write `E+` instead.
+ */
+template <class T>
+class tre_parser {
+
+public:
+    typedef plan<T>                               plan_type;
+    typedef typename plan_type::lower_bound_type  lower_bound_type;
+    typedef typename plan_type::upper_bound_type  upper_bound_type;
+
+    tre_parser(const std::string& text, plan_type& p) : text(text), pos(0), p(p) {}
+
+    std::size_t parse(){
+        std::size_t root = parse_union();
+        skip_space();
+        if(pos != text.size()){
+            fail("unexpected '" + std::string(1, text[pos]) + "'");
+        }
+        return root;
+    }
+
+private:
+    const std::string& text;
+    std::size_t pos;
+    plan_type& p;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::invalid_argument("tre: " + what + " at position " + std::to_string(pos) + " in '" + text + "'");
+    }
+
+    void skip_space(){
+        while(pos < text.size() and std::isspace(static_cast<unsigned char>(text[pos]))){
+            pos++;
+        }
+    }
+
+    bool accept(char c){
+        skip_space();
+        if(pos < text.size() and text[pos] == c){
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c){
+        if(!accept(c)){
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    static bool is_name_char(char c){
+        return std::isalnum(static_cast<unsigned char>(c)) or c == '_';
+    }
+
+    std::string name(){
+        skip_space();
+        std::size_t first = pos;
+        while(pos < text.size() and is_name_char(text[pos])){
+            pos++;
+        }
+        return text.substr(first, pos - first);
+    }
+
+    std::size_t parse_union(){
+        std::size_t lhs = parse_intersection();
+        while(accept('|')){
+            lhs = p.binary(plan_op::set_union, lhs, parse_intersection());
+        }
+        return lhs;
+    }
+
+    std::size_t parse_intersection(){
+        std::size_t lhs = parse_concatenation();
+        while(accept('&')){
+            lhs = p.binary(plan_op::intersection, lhs, parse_concatenation());
+        }
+        return lhs;
+    }
+
+    std::size_t parse_concatenation(){
+        std::size_t lhs = parse_unary();
+        while(accept(';')){
+            lhs = p.binary(plan_op::concatenation, lhs, parse_unary());
+        }
+        return lhs;
+    }
+
+    std::size_t parse_unary(){
+        if(accept('!')){
+            return p.unary(plan_op::complementation, parse_unary());
+        }
+        return parse_postfix();
+    }
+
+    std::size_t parse_postfix(){
+        std::size_t e = parse_primary();
+        for(;;){
+            if(accept('*')){
+                pos--;
+                fail("Kleene star is not supported, use '+' for one or more repetitions");
+            } else if(accept('+')){
+                e = p.unary(plan_op::transitive_closure, e);
+            } else if(accept('%')){
+                e = parse_interval(plan_op::duration_restriction, e);
+            } else {
+                return e;
+            }
+        }
+    }
+
+    std::size_t parse_primary(){
+        if(accept('(')){
+            std::size_t e = parse_union();
+            expect(')');
+            return e;
+        }
+        if(accept('<')){
+            std::size_t e = parse_union();
+            expect('>');
+            expect('_');
+            return parse_interval(plan_op::duration_restriction, e);
+        }
+
+        std::string id = name();
+        if(id.empty()){
+            fail(pos < text.size() ? "unexpected '" + std::string(1, text[pos]) + "'" : "unexpected end of expression");
+        }
+
+        plan_op op;
+        if(modality(id, op)){
+            return parse_modality(op);
+        }
+        return p.atom(id);
+    }
+
+    std::size_t parse_modality(plan_op op){
+        lower_bound_type lbound = lower_bound_type::unbounded();
+        upper_bound_type ubound = upper_bound_type::unbounded();
+        interval(lbound, ubound);
+        expect('(');
+        std::size_t e = parse_union();
+        expect(')');
+        return p.bounded(op, e, lbound, ubound);
+    }
+
+    std::size_t parse_interval(plan_op op, std::size_t e){
+        lower_bound_type lbound = lower_bound_type::unbounded();
+        upper_bound_type ubound = upper_bound_type::unbounded();
+        interval(lbound, ubound);
+        return p.bounded(op, e, lbound, ubound);
+    }
+
+    void interval(lower_bound_type& lbound, upper_bound_type& ubound){
+        bool lclosed = accept('[');
+        if(!lclosed){
+            expect('(');
+        }
+        std::string a = number();
+        expect(',');
+        std::string b = number();
+        bool uclosed = accept(']');
+        if(!uclosed){
+            expect(')');
+        }
+        lbound = lower_bound_type(value(a), lclosed);
+        ubound = (b == "inf" or b == "infinity") ? upper_bound_type::unbounded() : upper_bound_type(value(b), uclosed);
+    }
+
+    std::string number(){
+        skip_space();
+        std::size_t first = pos;
+        while(pos < text.size() and (is_name_char(text[pos]) or text[pos] == '.' or text[pos] == '/' or
+              ((text[pos] == '-' or text[pos] == '+') and (pos == first or text[pos-1] == 'e' or text[pos-1] == 'E')))){
+            pos++;
+        }
+        if(pos == first){
+            fail("expected a number");
+        }
+        return text.substr(first, pos - first);
+    }
+
+    T value(const std::string& s) const {
+        return parse_value(s, static_cast<T*>(nullptr));
+    }
+
+    template <class V>
+    V parse_value(const std::string& s, V*) const {
+        std::istringstream in(s);
+        V v;
+        if(!(in >> v) or !in.eof()){
+            fail("invalid number '" + s + "'");
+        }
+        return v;
+    }
+
+    mpq_class parse_value(const std::string& s, mpq_class*) const {
+        mpq_class v;
+        if(v.set_str(s, 10) != 0){
+            fail("invalid number '" + s + "'");
+        }
+        v.canonicalize();
+        return v;
+    }
+
+    static bool modality(const std::string& id, plan_op& op){
+        static const std::map<std::string, plan_op> names = {
+            {"diamond_meets", plan_op::diamond_meets},
+            {"diamond_met_by", plan_op::diamond_met_by},
+            {"diamond_starts", plan_op::diamond_starts},
+            {"diamond_started_by", plan_op::diamond_started_by},
+            {"diamond_finishes", plan_op::diamond_finishes},
+            {"diamond_finished_by", plan_op::diamond_finished_by},
+            {"box_meets", plan_op::box_meets},
+            {"box_met_by", plan_op::box_met_by},
+            {"box_starts", plan_op::box_starts},
+            {"box_started_by", plan_op::box_started_by},
+            {"box_finishes", plan_op::box_finishes},
+            {"box_finished_by", plan_op::box_finished_by}
+        };
+        auto it = names.find(id);
+        if(it == names.end()){
+            return false;
+        }
+        op = it->second;
+        return true;
+    }
+};
+
+/**
+ *  @brief  Parses a TRE into a plan with a single output
+ */
+template <class T>
+plan<T> compile(const std::string& text){
+    plan<T> p;
+    p.add_output(tre_parser<T>(text, p).parse());
+    return p;
+}
+
+/**
+ *  @brief  Parses a TRE into an existing plan and adds it as an output
+ *  @return Index of the new output
+ */
+template <class T>
+std::size_t compile_into(plan<T>& p, const std::string& text){
+    p.add_output(tre_parser<T>(text, p).parse());
+    return p.outputs().size() - 1;
+}
+
+/**
+ *  @brief  Parses several TREs into one plan, one output per expression
+ *
+ *  Subexpressions common to several patterns become shared nodes, so
+ *  evaluating the plan computes each of them once.
+ */
+template <class T>
+plan<T> compile_many(const std::vector<std::string>& texts){
+    plan<T> p;
+    for(const auto& text : texts){
+        compile_into(p, text);
+    }
+    return p;
+}
+
+/**
+ *  Thread-safe cache of compiled plans keyed by their text.
+ */
+template <class T>
+class plan_cache {
+
+public:
+    std::shared_ptr< plan<T> > get(const std::string& text){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = plans.find(text);
+            if(it != plans.end()){
+                return it->second;
+            }
+        }
+        std::shared_ptr< plan<T> > compiled(new plan<T>(compile<T>(text)));
+        std::lock_guard<std::mutex> lock(mutex);
+        return plans.insert(std::make_pair(text, compiled)).first->second;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return plans.size();
+    }
+
+    void clear(){
+        std::lock_guard<std::mutex> lock(mutex);
+        plans.clear();
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::map< std::string, std::shared_ptr< plan<T> > > plans;
+};
+
+} // namespace timedrel
+
+#endif // TIMEDREL_TRE_PARSER_HPP
@@ -23,7 +23,19 @@ inline std::ostream& operator<< (std::ostream &os, const upper_bound<T>& b) {
 
 
 template <typename T>
-inline std::ostream& operator<< (std::ostream &os, const zone<T>& z) {
+inline std::ostream& operator<< (std::ostream &os, const closed_lower_bound<T>& b) {
+    os << b.value << " <=";
+    return os;
+}
+
+template <typename T>
+inline std::ostream& operator<< (std::ostream &os, const closed_upper_bound<T>& b) {
+    os << "<= " << b.value ;
+    return os;
+}
+
+template <typename T, typename Bound>
+inline std::ostream& operator<< (std::ostream &os, const zone<T, Bound>& z) {
 
     os << z.get_bmin() <<" b "<< z.get_bmax() <<", "<<
           z.get_emin() <<" e "<< z.get_emax() <<", "<<
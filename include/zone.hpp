@@ -12,21 +12,32 @@
 
 namespace timedrel {
 
-template <class T>
+/*
+ *  Which endpoints of a period are anchored when it is turned into a zone.
+ *  See `zone::make_from_period` and its `_rise/_fall/_both_anchor` variants.
+ */
+enum class period_anchor { none, rise, fall, both };
+
+/*
+ *  Zone over values of type T. The bound family `Bound` is `bound<T>`, with
+ *  a strictness flag per bound, or `closed_bound<T>` for zones whose bounds
+ *  are all non-strict (see `closed_zone`).
+ */
+template <class T, class Bound = bound<T>>
 class zone {
 
-template<typename T1>
-friend std::ostream& operator<<(std::ostream &os, const zone<T1>&);
+template<typename T1, typename Bound1>
+friend std::ostream& operator<<(std::ostream &os, const zone<T1, Bound1>&);
 
 public:
 
-    typedef T              value_type;
-    typedef bound<T>       bound_type;
-    typedef lower_bound<T> lower_bound_type;
-    typedef upper_bound<T> upper_bound_type;
+    typedef T                                  value_type;
+    typedef Bound                              bound_type;
+    typedef typename Bound::lower_bound_type   lower_bound_type;
+    typedef typename Bound::upper_bound_type   upper_bound_type;
 
-    typedef zone<T>        zone_type;
-    typedef zone<T>        type;
+    typedef zone<T, Bound> zone_type;
+    typedef zone<T, Bound> type;
 
 private:
 
@@ -97,6 +108,15 @@ public:
 
     }
 
+    /*
+     *  Constructs a zone from bounds that are already in canonical form,
+     *  e.g. bounds of a `make`-built zone read back from storage.
+     *  No normalization is applied.
+     */
+    static zone_type make_canonical(const lower_bound_type& bmin, const upper_bound_type& bmax,const lower_bound_type& emin,const upper_bound_type& emax, const lower_bound_type& dmin, const upper_bound_type& dmax){
+        return zone_type(bmin, bmax, emin, emax, dmin, dmax);
+    }
+
     static zone_type make(const std::array<T, 6>& values, const std::array<bool, 6>& signs){
         return make(
             lower_bound_type(values[0], signs[0]),
@@ -132,6 +152,15 @@ public:
         return make({begin, begin, end, end, end-begin, end-begin}, {1,1,1,1,1,1});
     }
 
+    static zone_type make_from_period(value_type begin, value_type end, period_anchor anchor){
+        switch(anchor){
+            case period_anchor::rise: return make_from_period_rise_anchor(begin, end);
+            case period_anchor::fall: return make_from_period_fall_anchor(begin, end);
+            case period_anchor::both: return make_from_period_both_anchor(begin, end);
+            default:                  return make_from_period(begin, end);
+        }
+    }
+
     static zone_type universal(){
         return make(
             lower_bound_type::unbounded(), upper_bound_type::unbounded(),
@@ -170,6 +199,19 @@ public:
 
     }
 
+    /*
+     *  Whether the zone is `make_from_period(b, e)` for its own b = bmin and
+     *  e = emax, i.e. holds every period within [b, e]
+     */
+    bool is_period() const {
+        return bmin == lower_bound_type::closed(bmin.value) and
+               bmax == upper_bound_type::open(emax.value) and
+               emin == lower_bound_type::open(bmin.value) and
+               emax == upper_bound_type::closed(emax.value) and
+               dmin == lower_bound_type::open(0) and
+               dmax == upper_bound_type::closed(emax.value - bmin.value);
+    }
+
     bool is_nonempty() const {
 
         return bound_type::is_valid_interval(bmin, bmax) and
@@ -178,12 +220,12 @@ public:
 
     }
 
-    inline lower_bound_type get_bmin() const {return bmin;}
-    inline upper_bound_type get_bmax() const {return bmax;}
-    inline lower_bound_type get_emin() const {return emin;}
-    inline upper_bound_type get_emax() const {return emax;}
-    inline lower_bound_type get_dmin() const {return dmin;}
-    inline upper_bound_type get_dmax() const {return dmax;}
+    inline const lower_bound_type& get_bmin() const {return bmin;}
+    inline const upper_bound_type& get_bmax() const {return bmax;}
+    inline const lower_bound_type& get_emin() const {return emin;}
+    inline const upper_bound_type& get_emax() const {return emax;}
+    inline const lower_bound_type& get_dmin() const {return dmin;}
+    inline const upper_bound_type& get_dmax() const {return dmax;}
 
     static bool includes(
         const zone_type& z1, 
@@ -197,8 +239,43 @@ public:
                upper_bound_type::includes(z1.get_dmax(), z2.get_dmax());
     }
 
+    /*
+     *  Whether some end of `z1` equals some begin of `z2`. `concatenation` of
+     *  a pair whose intervals only touch at an open bound is not empty, so
+     *  the sweeps only concatenate pairs that meet.
+     */
+    static bool meets(const zone_type& z1, const zone_type& z2){
+        return bound_type::is_valid_interval(lower_bound_type::intersection(z1.get_emin(), z2.get_bmin()),
+                                             upper_bound_type::intersection(z1.get_emax(), z2.get_bmax()));
+    }
+
     static zone_type concatenation(const zone_type& z1, const zone_type& z2){
 
+        return concatenation_bounds(z1, z2,
+            lower_bound_type::add(z1.get_dmin(), z2.get_dmin()),
+            upper_bound_type::add(z1.get_dmax(), z2.get_dmax()));
+
+    }
+
+    /*
+     *  Concatenation restricted to durations within [dmin1, dmax1], i.e.
+     *  `duration_restriction(concatenation(z1, z2), dmin1, dmax1)` computed at once.
+     */
+    static zone_type concatenation(const zone_type& z1, const zone_type& z2, const lower_bound_type& dmin1, const upper_bound_type& dmax1){
+
+        return concatenation_bounds(z1, z2,
+            lower_bound_type::intersection(lower_bound_type::add(z1.get_dmin(), z2.get_dmin()), dmin1),
+            upper_bound_type::intersection(upper_bound_type::add(z1.get_dmax(), z2.get_dmax()), dmax1));
+    }
+
+private:
+
+    /*
+     *  The begin and end bounds of the concatenation of `z1` and `z2`, shared by
+     *  both `concatenation` overloads, with the given duration bounds.
+     */
+    static zone_type concatenation_bounds(const zone_type& z1, const zone_type& z2, const lower_bound_type& dmin, const upper_bound_type& dmax){
+
         return make(
 
             lower_bound_type::intersection(
@@ -233,12 +310,14 @@ public:
                 )
             ),
 
-            lower_bound_type::add(z1.get_dmin(), z2.get_dmin()),
-            upper_bound_type::add(z1.get_dmax(), z2.get_dmax())
+            dmin,
+            dmax
         );
 
     }
 
+public:
+
     static zone_type intersection(const zone_type& z1, const zone_type& z2){
 
         return make(lower_bound_type::intersection(z1.bmin, z2.bmin),
@@ -274,8 +353,19 @@ public:
 
 };
 
-template <typename T>
-inline std::string toString(const zone<T>& z) {
+/*
+ *  Zone whose bounds are all non-strict. Bounds carry no strictness flag,
+ *  so the zone is half the size of a `zone<T>` for T = double and its
+ *  normalization and inclusion tests are plain min/max on values. Strict
+ *  bounds given to `make` are replaced by their closure, which is what the
+ *  robustness computations and period-only pipelines use anyway.
+ *  Complementation and the operators built on it are not available.
+ */
+template <class T>
+using closed_zone = zone<T, closed_bound<T>>;
+
+template <typename T, typename Bound>
+inline std::string toString(const zone<T, Bound>& z) {
     std::ostringstream ss;
     ss << z;
     return ss.str();
@@ -3,15 +3,27 @@
 
 #include <vector>
 #include <deque>
+#include <atomic>
+#include <memory>
+#include <iterator>
+#include <cstdint>
 #include <algorithm>
+#include <numeric>
 #include <sstream>
 #include <iostream>
 
 #include <string>
 #include <gmpxx.h>
+#include <stdexcept>
+#include <exception>
 #include <type_traits>
 
 #include "zone.hpp"
+#include "hashing.hpp"
+#include "interning.hpp"
+#include "block_index.hpp"
+#include "long_zones.hpp"
+#include "parallel.hpp"
 
 namespace timedrel {
 
@@ -60,14 +72,16 @@ zone<double> get_double_zone_from_rationals_zone(const zone<mpq_class> &z){
 
 template <class T>
 struct earlier_bmin {
-    inline bool operator() (const zone<T>& z1, const zone<T>& z2){
+    template <class Zone>
+    inline bool operator() (const Zone& z1, const Zone& z2) const {
         return (z1.get_bmin() < z2.get_bmin());
     }
 };
 
 template <class T>
 struct earlier_emin {
-    inline bool operator() (const zone<T>& z1, const zone<T>& z2){
+    template <class Zone>
+    inline bool operator() (const Zone& z1, const Zone& z2) const {
         return (z1.get_emin() < z2.get_emin());
     }
 };
@@ -100,8 +114,9 @@ friend std::ostream& operator<<(
 
 public:
     typedef T                                    value_type;
-    typedef zone<value_type>                     zone_type;
+    typedef typename Container::value_type       zone_type;
 
+    typedef typename zone_type::bound_type       bound_type;
     typedef typename zone_type::lower_bound_type lower_bound_type;
     typedef typename zone_type::upper_bound_type upper_bound_type;
 
@@ -121,6 +136,41 @@ public:
 protected:
     Container container;
 
+    /* Bumped by every mutating member, see `touch` */
+    std::uint64_t generation = 0;
+
+    /* Cached `fingerprint()`, 0 while unknown */
+    mutable std::atomic<std::uint64_t> fingerprint_cache{0};
+
+    /* Cached `is_period_list()`: 0 while unknown, 1 yes, 2 no */
+    mutable std::atomic<std::uint8_t> period_cache{0};
+
+    /* A `bounding_box()` and the generation it was computed at */
+    struct cached_box {
+        std::uint64_t generation;
+        block_summary<T> box;
+    };
+
+    /* Cached `bounding_box()`, stale unless its generation is current; accessed with the atomic shared_ptr functions */
+    mutable std::shared_ptr< const cached_box > box_cache;
+
+    /* Optional block summaries, see `build_block_index` */
+    std::shared_ptr< const block_index<T> > index;
+
+    /*
+     *  Forgets the cached properties and the block index, called by every
+     *  mutating member. Kept to plain stores: the box is only dropped by
+     *  moving to a new generation, and `bounding_box` rebuilds it when read.
+     */
+    void touch(){
+        generation++;
+        fingerprint_cache.store(0, std::memory_order_relaxed);
+        period_cache.store(0, std::memory_order_relaxed);
+        if(index){
+            index.reset();
+        }
+    }
+
 public:
     // zone_set() : container() { }
 
@@ -144,11 +194,143 @@ public:
     zone_set() = default;
     ~zone_set() = default;
 
-    zone_set(const zone_set_type& other) = default;
-    zone_set(zone_set_type&& c) = default;
+    zone_set(const zone_set_type& other) :
+        container(other.container),
+        generation(other.generation),
+        fingerprint_cache(other.fingerprint_cache.load(std::memory_order_relaxed)),
+        period_cache(other.period_cache.load(std::memory_order_relaxed)),
+        box_cache(std::atomic_load(&other.box_cache)),
+        index(other.index) {}
+
+    /* The caches move without throwing, so vectors of zone sets move their elements on growth */
+    zone_set(zone_set_type&& other) noexcept(std::is_nothrow_move_constructible<Container>::value) :
+        container(std::move(other.container)),
+        generation(other.generation),
+        fingerprint_cache(other.fingerprint_cache.load(std::memory_order_relaxed)),
+        period_cache(other.period_cache.load(std::memory_order_relaxed)),
+        box_cache(std::atomic_load(&other.box_cache)),
+        index(std::move(other.index)) {
+        other.touch();
+    }
+
+    zone_set_type& operator=(const zone_set_type& other){
+        if(this != &other){
+            container = other.container;
+            generation = other.generation;
+            fingerprint_cache.store(other.fingerprint_cache.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            period_cache.store(other.period_cache.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            std::atomic_store(&box_cache, std::atomic_load(&other.box_cache));
+            index = other.index;
+        }
+        return *this;
+    }
+
+    zone_set_type& operator=(zone_set_type&& other) noexcept(std::is_nothrow_move_assignable<Container>::value){
+        if(this != &other){
+            container = std::move(other.container);
+            generation = other.generation;
+            fingerprint_cache.store(other.fingerprint_cache.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            period_cache.store(other.period_cache.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            std::atomic_store(&box_cache, std::atomic_load(&other.box_cache));
+            index = std::move(other.index);
+            other.touch();
+        }
+        return *this;
+    }
 
-    zone_set_type& operator=(const zone_set_type& other) = default;
-    zone_set_type& operator=(zone_set_type&& other) = default;
+    /**
+     *  @brief  Content hash of the sequence of zones
+     *
+     *  Computed on first use and kept until the set is modified through one of
+     *  its members; zones must not be changed in place through iterators or
+     *  references. Equal sequences have equal fingerprints.
+     */
+    std::uint64_t fingerprint() const {
+        std::uint64_t h = fingerprint_cache.load(std::memory_order_relaxed);
+        if(h == 0){
+            h = hashing::mix(container.size());
+            for(const auto& z : container){
+                h = hashing::combine(h, hashing::value(z));
+            }
+            if(h == 0){
+                h = 1;
+            }
+            fingerprint_cache.store(h, std::memory_order_relaxed);
+        }
+        return h;
+    }
+
+    /**
+     *  @brief  Whether the set is a plain list of periods
+     *
+     *  True when every zone is a period zone (`zone::is_period`) and both the
+     *  begins and the ends strictly increase, which is what `add_from_period`
+     *  on the periods of a signal and the boolean operators on such sets
+     *  produce. Boolean operators on two period lists run as linear merges
+     *  of intervals instead of zone sweeps. Cached like `fingerprint()`.
+     */
+    bool is_period_list() const {
+        std::uint8_t c = period_cache.load(std::memory_order_relaxed);
+        if(c == 0){
+            bool periods = true;
+            for(auto it = container.cbegin(); periods and it != container.cend(); it++){
+                periods = it->is_period() and
+                    (it == container.cbegin() or
+                     (std::prev(it)->get_bmin().value < it->get_bmin().value and
+                      std::prev(it)->get_emax().value < it->get_emax().value));
+            }
+            c = periods ? 1 : 2;
+            period_cache.store(c, std::memory_order_relaxed);
+        }
+        return c == 1;
+    }
+
+    /**
+     *  @brief  Value hull of all the zones, see %block_summary
+     *
+     *  Computed on first use and cached like `fingerprint()`. `includes`
+     *  compares the hulls of its operands before sweeping them. Throws
+     *  std::invalid_argument if the set is empty.
+     */
+    block_summary<T> bounding_box() const {
+        if(container.empty()){
+            throw std::invalid_argument("zone_set::bounding_box: empty set");
+        }
+        std::shared_ptr< const cached_box > cached = std::atomic_load(&box_cache);
+        if(!cached or cached->generation != generation){
+            cached = std::make_shared< const cached_box >(cached_box{
+                generation, make_block_summaries<T>(container.cbegin(), container.cend(), container.size()).front()});
+            std::atomic_store(&box_cache, cached);
+        }
+        return cached->box;
+    }
+
+    /**
+     *  @brief  Attaches summaries of consecutive blocks of zones
+     *  @param  block_size  Zones per block
+     *
+     *  With the index, `intersection`, `includes`, `concatenation` (right
+     *  operand) and the robustness queries skip whole blocks that cannot
+     *  meet the other operand, which pays off on sparse, long traces. The
+     *  index is dropped, like the cached fingerprint, when the set is
+     *  modified. Throws std::invalid_argument if the set is not sorted by
+     *  bmin or the block size is 0.
+     */
+    void build_block_index(std::size_t block_size = 64){
+        if(block_size == 0){
+            throw std::invalid_argument("zone_set::build_block_index: block size must be positive");
+        }
+        if(!is_sorted_by_bmin()){
+            throw std::invalid_argument("zone_set::build_block_index: zones must be sorted by bmin");
+        }
+        index = std::make_shared< const block_index<T> >(block_index<T>{
+            block_size, make_block_summaries<T>(container.cbegin(), container.cend(), block_size)});
+    }
+
+    /* The attached block index, or nullptr */
+    const block_index<T>* get_block_index() const {
+        return index.get();
+    }
 
     bool empty() const {
         return container.empty();
@@ -159,6 +341,15 @@ public:
     size_type size() const {
         return container.size();
     }
+    void reserve(size_type n){
+        container.reserve(n);
+    }
+    /*
+     *  The non-const accessors do not reset the cached properties or the
+     *  block index, so that reading a set keeps them. Only the members that
+     *  add, remove or reorder zones do; zones must not be changed in place
+     *  through these iterators and references.
+     */
     iterator begin(){
         return container.begin();
     }
@@ -195,61 +386,75 @@ public:
     }
 
     void sort_by_bmin(){
-        std::sort(begin(), end(), earlier_bmin<value_type>());
+        touch();
+        std::sort(container.begin(), container.end(), earlier_bmin<value_type>());
     }
 
     void sort_by_emin(){
-        std::sort(begin(), end(), earlier_emin<value_type>());
+        touch();
+        std::sort(container.begin(), container.end(), earlier_emin<value_type>());
     }
 
-    void is_sorted_by_bmin(){
-        std::is_sorted(begin(), end(), earlier_bmin<value_type>());
+    bool is_sorted_by_bmin() const {
+        return std::is_sorted(cbegin(), cend(), earlier_bmin<value_type>());
     }
 
-    void is_sorted_by_emin(){
-        std::is_sorted(begin(), end(), earlier_emin<value_type>());
+    bool is_sorted_by_emin() const {
+        return std::is_sorted(cbegin(), cend(), earlier_emin<value_type>());
     }
 
     iterator erase(iterator position){
+        touch();
         return container.erase(position);
     }
 
     iterator erase(iterator first, iterator last){
+        touch();
         return container.erase(first, last);   
     }
     void clear(){
+        touch();
         container.clear();
     }
     void push_back(const zone_type& z) {
+        touch();
         container.push_back(z);
     }
     void push_back(zone_type&& z) {
+        touch();
         container.push_back(std::move(z));
     }
     iterator insert(iterator pos, const zone_type& z) {
+        touch();
         return container.insert(pos, z);
     }
     iterator insert(const_iterator pos, const zone_type& z) {
+        touch();
         return container.insert(pos, z);
     }
     iterator insert(const_iterator pos, zone_type&& z ){
+        touch();
         return container.insert(pos, z);
     }
     template< class InputIt >
     void insert(iterator pos, InputIt first, InputIt last){
+        touch();
         container.insert(pos, first, last);
     }
     template< class InputIt >
     iterator insert(const_iterator pos, InputIt first, InputIt last){
+        touch();
         return container.insert(pos, first, last);
     }
 
     void add(const zone_type& z){
         if(!z.is_nonempty()){return;}
+        touch();
         container.push_back(z);
     }
     void add(zone_type&& z){
         if(!z.is_nonempty()){return;}
+        touch();
         container.push_back(std::move(z));
     }
     void add(const std::array<value_type,6>& values, 
@@ -274,6 +479,66 @@ public:
         add(zone_type::make_from_period_both_anchor(begin, end));
     }
 
+    /**
+     *  @brief  Bulk construction from row-major bound arrays
+     *  @param  values       n x 6 values ordered as bmin, bmax, emin, emax, dmin, dmax
+     *  @param  signs        n x 6 strictness flags, or nullptr for the default signs of `add`
+     *  @param  n            Number of zones
+     *  @param  num_threads  Threads used to normalize and sort (0 uses all hardware threads)
+     *  @return %zone_set sorted by bmin
+     *
+     *  Each row is normalized with `zone::make` and empty zones are dropped as in `add`.
+     *  Throws std::invalid_argument if a value is NaN.
+     */
+    static zone_set_type from_arrays(
+        const value_type* values,
+        const bool* signs,
+        size_type n,
+        unsigned num_threads = 1){
+
+        return build_sorted(n, num_threads, [values, signs](size_type i){
+            std::array<value_type, 6> v;
+            std::array<bool, 6> s = {{1,0,0,1,0,1}};
+            for(size_type k = 0; k < 6; k++){
+                v[k] = values[6*i + k];
+                if(is_nan(v[k])){
+                    throw std::invalid_argument("zone_set::from_arrays: NaN in row " + std::to_string(i));
+                }
+                if(signs != nullptr){
+                    s[k] = signs[6*i + k];
+                }
+            }
+            return zone_type::make(v, s);
+        });
+    }
+
+    /**
+     *  @brief  Bulk construction from period arrays
+     *  @param  begins       n period begin times
+     *  @param  ends         n period end times
+     *  @param  n            Number of periods
+     *  @param  anchor       Anchoring as in the `add_from_period*` family
+     *  @param  num_threads  Threads used to normalize and sort (0 uses all hardware threads)
+     *  @return %zone_set sorted by bmin
+     *
+     *  Periods that yield empty zones (e.g. begin > end) are dropped as in `add_from_period`.
+     *  Throws std::invalid_argument if a value is NaN.
+     */
+    static zone_set_type from_periods(
+        const value_type* begins,
+        const value_type* ends,
+        size_type n,
+        period_anchor anchor = period_anchor::none,
+        unsigned num_threads = 1){
+
+        return build_sorted(n, num_threads, [begins, ends, anchor](size_type i){
+            if(is_nan(begins[i]) or is_nan(ends[i])){
+                throw std::invalid_argument("zone_set::from_periods: NaN in period " + std::to_string(i));
+            }
+            return zone_type::make_from_period(begins[i], ends[i], anchor);
+        });
+    }
+
     zone_set<mpq_class> get_as_rationals() const{
         // Create an empty zone_set with rationals
         zone_set<mpq_class> zsq;
@@ -341,99 +606,726 @@ public:
         return s;
     }
 
+protected:
+
+    /*
+     *  Active lists of the sweeps. They are kept per thread so that their
+     *  capacity carries over from one operation to the next; `get` returns
+     *  them empty. Sweeps never nest, so one set per thread is enough.
+     */
+    struct sweep_scratch {
+        Container act_1, act_2, act_r, act_r_temp;
+
+        static sweep_scratch& get(){
+            static thread_local sweep_scratch scratch;
+            scratch.act_1.clear();
+            scratch.act_2.clear();
+            scratch.act_r.clear();
+            scratch.act_r_temp.clear();
+            return scratch;
+        }
+    };
+
+    template <class V>
+    static bool is_nan(const V& v){
+        return !(v == v);
+    }
+
+    /*
+     *  Builds zones `make_zone(0), ..., make_zone(n-1)` in contiguous chunks,
+     *  drops empty ones, sorts every chunk by bmin on its own thread and
+     *  merges the chunks in order. Exceptions from a chunk are rethrown here.
+     */
+    template <class Maker>
+    static zone_set_type build_sorted(size_type n, unsigned num_threads, Maker make_zone){
+
+        std::vector<std::size_t> borders = chunk_borders(n, num_threads);
+        std::size_t chunks = borders.size() - 1;
+
+        std::vector<zone_set_type> parts(chunks);
+        std::vector<std::exception_ptr> errors(chunks);
+
+        parallel_for(n, chunks, [&](std::size_t first, std::size_t last, unsigned k){
+            try {
+                for(std::size_t i = first; i < last; i++){
+                    parts[k].add(make_zone(i));
+                }
+                if(!parts[k].is_sorted_by_bmin()){
+                    parts[k].sort_by_bmin();
+                }
+            } catch(...) {
+                errors[k] = std::current_exception();
+            }
+        });
+
+        for(const auto& e : errors){
+            if(e){
+                std::rethrow_exception(e);
+            }
+        }
+
+        zone_set_type result = std::move(parts[0]);
+        for(std::size_t k = 1; k < chunks; k++){
+            auto middle = result.container.insert(result.container.end(), parts[k].cbegin(), parts[k].cend());
+            std::inplace_merge(result.container.begin(), middle, result.container.end(), earlier_bmin<value_type>());
+        }
+        return result;
+    }
+
+    /*
+     *  Concatenation sweep of `zs1`, sorted by emin, against `zs2`, sorted by bmin.
+     *  Every pair whose meeting intervals overlap and that passes `accept` gets
+     *  its zone from `make`; a left zone leaves the active list once `expired`
+     *  holds for the current right zone. Results are appended to `result`,
+     *  not sorted.
+     */
+    template <class Accept, class Make, class Expired>
+    static void concatenation_sweep(const zone_set_type& zs1, const zone_set_type& zs2,
+                                    Accept accept, Make make, Expired expired, zone_set_type& result){
+
+        sweep_scratch& scratch = sweep_scratch::get();
+        Container &act_1 = scratch.act_1, &act_2 = scratch.act_2, &act_r = scratch.act_r, &act_r_temp = scratch.act_r_temp;
+
+        auto combine = [&](const zone_type& z1, const zone_type& z2, const lower_bound_type& front){
+
+            if(!zone_type::meets(z1, z2) or !accept(z1, z2)){
+                return;
+            }
+
+            auto kid = make(z1, z2);
+
+            if( kid.is_nonempty() and
+                !std::any_of(act_r.begin(), act_r.end(), [&kid](const zone_type &zr){return zone_type::includes(zr, kid);}))
+            {
+                act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](const zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
+                act_r.push_back(kid);
+
+                act_r_temp.clear();
+                for(const auto& zr : act_r){
+                    if( zr.get_bmax() < front){
+                        result.container.push_back(zr);
+                    }
+                    else {
+                        act_r_temp.push_back(zr);
+                    }
+                }
+                std::swap(act_r, act_r_temp);
+            }
+        };
+
+        auto it1 = zs1.cbegin();
+        auto it2 = zs2.cbegin();
+
+        while(it1 != zs1.cend() or it2 != zs2.cend()) {
+
+            if (it2 == zs2.cend() or (it1 != zs1.cend() and it1->get_emin() < it2->get_bmin())){
+                if(it2 == zs2.cend() and act_2.empty()){
+                    break;
+                }
+                act_1.push_back(*it1);
+                act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](const zone_type& z2){return z2.get_bmax() < it1->get_emin();}), act_2.end());
+
+                for(const auto& z2 : act_2){
+                    combine(*it1, z2, it1->get_bmin());
+                }
+                it1++;
+
+            } else {
+                act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](const zone_type& z1){return expired(z1, *it2);}), act_1.end());
+                if(it1 == zs1.cend() and act_1.empty()){
+                    break;
+                }
+                act_2.push_back(*it2);
+
+                for(const auto& z1 : act_1){
+                    combine(z1, *it2, it2->get_bmin());
+                }
+                it2++;
+            }
+        }
+
+        for(const auto& zr : act_r){
+            result.container.push_back(zr);
+        }
+    }
+
+    /*
+     *  Moves `it`, at a block border of an indexed `zs`, past the following
+     *  blocks for which `isolated` holds, i.e. that cannot produce any result
+     *  against the rest of the other operand. Without an index returns `it`.
+     */
+    template <class Isolated>
+    static const_iterator skip_blocks(const zone_set_type& zs, const_iterator it, Isolated isolated){
+        if(!zs.index){
+            return it;
+        }
+        const std::size_t size = zs.container.size();
+        const std::size_t block_size = zs.index->block_size;
+        std::size_t pos = std::distance(zs.cbegin(), it);
+        while(pos < size and pos % block_size == 0 and isolated(zs.index->blocks[pos / block_size])){
+            pos = std::min(pos + block_size, size);
+        }
+        return std::next(zs.cbegin(), pos);
+    }
+
+    /*
+     *  The values `key1(z)` of the zones of `zs1` and `key2(z)` of `zs2`, by
+     *  address, merged in order: the steps of a sweep over both operands.
+     */
+    template <class Key1, class Key2>
+    static std::vector<const value_type*> sweep_events(const zone_set_type& zs1, Key1 key1, const zone_set_type& zs2, Key2 key2){
+        std::vector<const value_type*> events1, events2, events;
+        events1.reserve(zs1.size());
+        events2.reserve(zs2.size());
+        for(const auto& z : zs1.container){
+            events1.push_back(&key1(z));
+        }
+        for(const auto& z : zs2.container){
+            events2.push_back(&key2(z));
+        }
+        events.reserve(events1.size() + events2.size());
+        std::merge(events1.cbegin(), events1.cend(), events2.cbegin(), events2.cend(), std::back_inserter(events),
+            [](const value_type* a, const value_type* b){ return *a < *b; });
+        return events;
+    }
+
+    /* Zones taken out of a sweep and indexed on their key interval, see `intersection` */
+    struct long_zones {
+        zone_set_type zones;
+        long_zone_index<value_type> index;
+    };
+
+    /*
+     *  For every zone of `zs`, sorted by `lo`, the number of the sorted
+     *  `events` within [lo(z), hi(z)]: how many steps of the sweep it stays
+     *  active. The counts only steer strategies, so an unsorted `zs` is
+     *  harmless.
+     */
+    template <class Lo, class Hi>
+    static std::vector<std::size_t> event_spans(const zone_set_type& zs, const std::vector<const value_type*>& events, Lo lo, Hi hi){
+        std::vector<std::size_t> spans;
+        spans.reserve(zs.size());
+        auto first = events.cbegin();
+        for(const auto& z : zs.container){
+            while(first != events.cend() and **first < lo(z)){
+                first++;
+            }
+            spans.push_back(std::upper_bound(first, events.cend(), &hi(z),
+                [](const value_type* v, const value_type* e){ return *v < *e; }) - first);
+        }
+        return spans;
+    }
+
+    /* Zones of `zs` not yet interned in `table`, in the order of `zs` */
+    static zone_set_type fresh_zones(const zone_set_type& zs, zone_interner<zone_type>& table){
+        zone_set_type result;
+        for(const auto& z : zs.container){
+            if(table.insert(z)){
+                result.container.push_back(z);
+            }
+        }
+        return result;
+    }
+
+    /*
+     *  Number of pairs of zones, from either operand, where the `lo` value
+     *  of the second lies within [lo, hi] of the first: `event_spans` for
+     *  keys the zones are not sorted by.
+     */
+    template <class Lo, class Hi>
+    static std::size_t overlap_pairs(const zone_set_type& zs1, const zone_set_type& zs2, Lo lo, Hi hi){
+        std::vector<const value_type*> events;
+        events.reserve(zs1.size() + zs2.size());
+        for(const auto& z : zs1.container){
+            events.push_back(&lo(z));
+        }
+        for(const auto& z : zs2.container){
+            events.push_back(&lo(z));
+        }
+        auto earlier = [](const value_type* a, const value_type* b){ return *a < *b; };
+        std::sort(events.begin(), events.end(), earlier);
+
+        std::size_t pairs = 0;
+        for(const zone_set_type* zs : {&zs1, &zs2}){
+            for(const auto& z : zs->container){
+                pairs += std::upper_bound(events.cbegin(), events.cend(), &hi(z), earlier) -
+                         std::lower_bound(events.cbegin(), events.cend(), &lo(z), earlier);
+            }
+        }
+        return pairs;
+    }
+
+    /*
+     *  Moves the zones of `zs` whose event span is above `long_zone_events`
+     *  to `longs`, indexed on [lo(z), hi(z)], and the others to `shorts`,
+     *  keeping their order. Returns false, leaving both empty, if there is
+     *  no long zone.
+     */
+    template <class Lo, class Hi>
+    static bool split_long_zones(const zone_set_type& zs, const std::vector<std::size_t>& spans, Lo lo, Hi hi,
+                                 zone_set_type& shorts, long_zones& longs){
+        std::vector<bool> is_long(zs.size());
+        std::size_t count = 0;
+        for(std::size_t i = 0; i < zs.size(); i++){
+            is_long[i] = spans[i] > long_zone_events;
+            count += is_long[i];
+        }
+        if(count == 0){
+            return false;
+        }
+
+        shorts.container.reserve(zs.size() - count);
+        longs.zones.container.reserve(count);
+        for(std::size_t i = 0; i < zs.size(); i++){
+            (is_long[i] ? longs.zones : shorts).container.push_back(zs.container[i]);
+        }
+        for(std::size_t i = 0; i < count; i++){
+            longs.index.add(lo(longs.zones.container[i]), hi(longs.zones.container[i]), i);
+        }
+        longs.index.build();
+        if(zs.index){
+            shorts.build_block_index(zs.index->block_size);
+        }
+        return true;
+    }
+
+    /* Whether every zone of `active` has bmax before `v` */
+    static bool ends_before(const Container& active, const value_type& v){
+        return std::all_of(active.cbegin(), active.cend(), [&v](const zone_type& z){return z.get_bmax().value < v;});
+    }
+
+    /*
+     *  Intersection of two period lists: the overlaps met by the usual
+     *  two-pointer walk, which come out sorted by begin and by end, minus the
+     *  ones included in a neighbour. Overlaps the walk skips are included in
+     *  one it meets.
+     */
+    static zone_set_type period_intersection(const zone_set_type& zs1, const zone_set_type& zs2){
+
+        zone_set_type result = zone_set();
+
+        auto it1 = zs1.cbegin();
+        auto it2 = zs2.cbegin();
+        while(it1 != zs1.cend() and it2 != zs2.cend()){
+            const value_type& b = std::max(it1->get_bmin().value, it2->get_bmin().value);
+            bool first_ends = it1->get_emax().value < it2->get_emax().value;
+            const value_type& e = first_ends ? it1->get_emax().value : it2->get_emax().value;
+
+            if(b < e){
+                while(!result.empty() and result.container.back().get_bmin().value == b){
+                    result.container.pop_back();
+                }
+                if(result.empty() or result.container.back().get_emax().value < e){
+                    result.container.push_back(zone_type::make_from_period(b, e));
+                }
+            }
+            if(first_ends){
+                it1++;
+            } else {
+                it2++;
+            }
+        }
+        result.period_cache.store(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    /* Union of two period lists: a merge by begin that drops included periods */
+    static zone_set_type period_union(const zone_set_type& zs1, const zone_set_type& zs2){
+
+        zone_set_type result = zone_set();
+        result.container.reserve(zs1.size() + zs2.size());
+
+        auto it1 = zs1.cbegin();
+        auto it2 = zs2.cbegin();
+        while(it1 != zs1.cend() or it2 != zs2.cend()){
+            /* On equal begins the longer period goes first */
+            bool take_first = it2 == zs2.cend() or
+                (it1 != zs1.cend() and
+                 (it1->get_bmin().value < it2->get_bmin().value or
+                  (it1->get_bmin().value == it2->get_bmin().value and !(it1->get_emax().value < it2->get_emax().value))));
+            const zone_type& z = take_first ? *it1++ : *it2++;
+            if(result.empty() or result.container.back().get_emax().value < z.get_emax().value){
+                result.container.push_back(z);
+            }
+        }
+        result.period_cache.store(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    /* The first period of `zs2` within no period of `zs1`, both period lists */
+    static const_iterator period_first_uncovered(const zone_set_type& zs1, const zone_set_type& zs2){
+
+        auto it1 = zs1.cbegin();
+        for(auto it2 = zs2.cbegin(); it2 != zs2.cend(); it2++){
+            /* The first period of zs1 that ends late enough begins the earliest */
+            while(it1 != zs1.cend() and it1->get_emax().value < it2->get_emax().value){
+                it1++;
+            }
+            if(it1 == zs1.cend() or it2->get_bmin().value < it1->get_bmin().value){
+                return it2;
+            }
+        }
+        return zs2.cend();
+    }
+
+    /* Whether `z` includes every point of the box `b` */
+    static bool includes_box(const zone_type& z, const block_summary<value_type>& b){
+        return lower_bound_type::includes(z.get_bmin(), lower_bound_type::closed(b.bmin)) and
+               upper_bound_type::includes(z.get_bmax(), upper_bound_type::closed(b.bmax)) and
+               lower_bound_type::includes(z.get_emin(), lower_bound_type::closed(b.emin)) and
+               upper_bound_type::includes(z.get_emax(), upper_bound_type::closed(b.emax)) and
+               lower_bound_type::includes(z.get_dmin(), lower_bound_type::closed(b.dmin)) and
+               upper_bound_type::includes(z.get_dmax(), upper_bound_type::closed(b.dmax));
+    }
+
+public:
+
     static zone_set_type filter(const zone_set_type &zs){
+
+        if(zs.is_period_list()){
+            return zs;
+        }
  
-        zone_set_type active, active_temp;
+        sweep_scratch& scratch = sweep_scratch::get();
+        Container &active = scratch.act_1, &active_temp = scratch.act_2;
         zone_set_type result = zone_set();
   
         // for(const auto& z1 : zs){
         for(auto z1it = zs.cbegin(); z1it != zs.cend(); z1it++){
  
-            bool already_included = std::any_of(active.begin(), active.end(), [z1it](zone_type &z2){return zone_type::includes(z2, *z1it);});
+            bool already_included = std::any_of(active.begin(), active.end(), [z1it](const zone_type& z2){return zone_type::includes(z2, *z1it);});
  
             if(!already_included){
  
-                active.erase( std::remove_if(active.begin(), active.end(), [z1it](zone_type &z2){return zone_type::includes(*z1it, z2);}), active.end());
+                active.erase( std::remove_if(active.begin(), active.end(), [z1it](const zone_type& z2){return zone_type::includes(*z1it, z2);}), active.end());
                 active.push_back(*z1it);
  
                 active_temp.clear();
                 for(const auto& z2 : active){
                     if( z2.get_bmax() < z1it->get_bmin()){
-                        result.push_back(z2);
+                        result.container.push_back(z2);
                     } else {
                         active_temp.push_back(z2);
                     }
                 }
-                active = active_temp;
+                std::swap(active, active_temp);
             }
         }
         for(const auto& z2 : active){
-            result.push_back(z2);
+            result.container.push_back(z2);
         }
 
         result.sort_by_bmin();
         return result;
     }
 
-    static bool includes(const zone_set_type& zs1, const zone_set_type& zs2){
+    /**
+     *  @brief  Filter on several threads
+     *  @param  zs  A %zone_set in any order
+     *  @param  num_threads  Number of threads, `0` for all hardware threads
+     *  @return Same %zone_set as `filter` on `zs` sorted by bmin
+     */
+    static zone_set_type filter_parallel(const zone_set_type& zs, unsigned num_threads = 0){
+        return filter_parallel(std::vector<zone_set_type>(1, zs), num_threads);
+    }
 
-        // std::sort(zs1.begin(), zs1.end(), earlier_bmin<value_type>());
-        // std::sort(zs2.begin(), zs2.end(), earlier_bmin<value_type>());
+    /**
+     *  @brief  Filter of the union of several %zone_sets on several threads
+     *
+     *  The bmin axis is cut at sampled quantiles. Each chunk sorts the zones
+     *  whose bmin falls inside it, together with the earlier zones whose bmax
+     *  reaches it (the only ones that can include them), filters them and
+     *  keeps its own zones. Chunk results are concatenated in order.
+     */
+    static zone_set_type filter_parallel(const std::vector<zone_set_type>& parts, unsigned num_threads = 0){
+
+        if(num_threads == 0){
+            num_threads = hardware_threads();
+        }
+
+        std::size_t total = 0;
+        for(const auto& p : parts){
+            total += p.size();
+        }
+
+        if(num_threads <= 1 or total < 2 * num_threads){
+            zone_set_type all;
+            all.container.reserve(total);
+            for(const auto& p : parts){
+                all.insert(all.end(), p.cbegin(), p.cend());
+            }
+            all.sort_by_bmin();
+            return filter(all);
+        }
 
-        if(zs2.empty()){
+        const std::size_t k = num_threads;
+
+        std::vector<value_type> sample;
+        for(const auto& p : parts){
+            std::size_t stride = std::max<std::size_t>(1, total / (64 * k));
+            for(std::size_t i = 0; i < p.size(); i += stride){
+                sample.push_back(p.container[i].get_bmin().value);
+            }
+        }
+        std::sort(sample.begin(), sample.end());
+
+        std::vector<value_type> cuts;
+        for(std::size_t j = 1; j < k; j++){
+            cuts.push_back(sample[j * sample.size() / k]);
+        }
+
+        auto chunk_of = [&](const value_type& v){
+            return static_cast<std::size_t>(std::upper_bound(cuts.begin(), cuts.end(), v) - cuts.begin());
+        };
+
+        /* own[i][j] and reaching[i][j]: zones of part i whose bmin is in chunk j, or whose [bmin, bmax] reaches it from before */
+        std::vector<std::vector<zone_set_type>> own(parts.size(), std::vector<zone_set_type>(k));
+        std::vector<std::vector<zone_set_type>> reaching(parts.size(), std::vector<zone_set_type>(k));
+
+        parallel_for(parts.size(), num_threads, [&](std::size_t first, std::size_t last, unsigned){
+            for(std::size_t i = first; i < last; i++){
+                for(const auto& z : parts[i]){
+                    std::size_t from = chunk_of(z.get_bmin().value);
+                    std::size_t to = std::min(chunk_of(z.get_bmax().value), k - 1);
+                    own[i][from].push_back(z);
+                    for(std::size_t j = from + 1; j <= to; j++){
+                        reaching[i][j].push_back(z);
+                    }
+                }
+            }
+        });
+
+        std::vector<zone_set_type> results(k);
+        parallel_for(k, num_threads, [&](std::size_t first, std::size_t last, unsigned){
+            for(std::size_t j = first; j < last; j++){
+                zone_set_type in;
+                std::size_t size = 0;
+                for(std::size_t i = 0; i < parts.size(); i++){
+                    size += reaching[i][j].size() + own[i][j].size();
+                }
+                in.container.reserve(size);
+                for(std::size_t i = 0; i < parts.size(); i++){
+                    in.insert(in.end(), reaching[i][j].cbegin(), reaching[i][j].cend());
+                    in.insert(in.end(), own[i][j].cbegin(), own[i][j].cend());
+                }
+                in.sort_by_bmin();
+
+                results[j] = filter(in);
+                auto& r = results[j].container;
+                r.erase(r.begin(), std::partition_point(r.begin(), r.end(), [&](const zone_type& z){ return chunk_of(z.get_bmin().value) < j; }));
+            }
+        });
+
+        zone_set_type result;
+        result.container.reserve(total);
+        for(const auto& r : results){
+            result.container.insert(result.container.end(), r.cbegin(), r.cend());
+        }
+        return result;
+    }
+
+    /**
+     *  @brief  Whether every zone of `zs2` is included in a zone of `zs1`
+     *  @param  zs1  A %zone_set sorted by bmin
+     *  @param  zs2  A %zone_set sorted by bmin
+     *
+     *  Zones are normalized, so each bound of a zone is reached by some of
+     *  its points and a `zs2` whose `bounding_box()` sticks out of the box of
+     *  `zs1` is not included. A single zone of `zs1` including the whole box
+     *  of `zs2` includes every zone of it. Both answers come from the cached
+     *  boxes; other cases run `first_uncovered`.
+     */
+    static bool includes(const zone_set_type& zs1, const zone_set_type& zs2){
+
+        if(zs2.empty() or &zs1 == &zs2){
             return true;
         } else if(zs1.empty()){
             return false;
         }
 
+        const block_summary<value_type> box2 = zs2.bounding_box();
+        if(!summary_includes(zs1.bounding_box(), box2)){
+            return false;
+        } else if(zs1.size() == 1 and includes_box(zs1.container.front(), box2)){
+            return true;
+        }
+        return first_uncovered(zs1, zs2) == zs2.cend();
+    }
+
+    /**
+     *  @brief  The first zone of `zs2` included in no zone of `zs1`
+     *  @param  zs1  A %zone_set sorted by bmin
+     *  @param  zs2  A %zone_set sorted by bmin
+     *  @return An iterator into `zs2`, `zs2.cend()` if `zs1` includes `zs2`
+     *
+     *  The sweep stops at the first uncovered zone, which is the one to
+     *  look at when an inclusion check unexpectedly fails.
+     */
+    static const_iterator first_uncovered(const zone_set_type& zs1, const zone_set_type& zs2){
+
+        if(zs1.is_period_list() and zs2.is_period_list()){
+            return period_first_uncovered(zs1, zs2);
+        }
+
         auto act_1 = zone_set();
 
         auto it1 = zs1.cbegin();
         auto it2 = zs2.cbegin();
 
+        // Zones of zs1 ending before z2 cannot cover z2 or the zones after it
+        auto covered = [&](const zone_type& z2){
+            act_1.container.erase( std::remove_if(act_1.container.begin(), act_1.container.end(), [&](const zone_type& z1){return z1.get_bmax() < z2.get_bmin();}), act_1.container.end());
+            return std::any_of(act_1.container.cbegin(), act_1.container.cend(), [&](const zone_type& z1){return zone_type::includes(z1, z2);});
+        };
+
         while(it1 != zs1.cend() and it2 != zs2.cend()) {
 
-            if (it1->get_bmin() < it2->get_bmax()){ //  z1.bmin < z2.bmin
-                act_1.push_back(*it1);
+            it1 = skip_blocks(zs1, it1, [&](const block_summary<value_type>& b){return b.bmax < it2->get_bmin().value;});
+            if(it1 == zs1.cend()){
+                break;
+            }
+
+            if (!(it2->get_bmin() < it1->get_bmin())){ //  z1.bmin <= z2.bmin
+                act_1.container.push_back(*it1);
                 it1++;
             } else {
-                act_1.erase( std::remove_if(act_1.begin(), act_1.end(), [&](zone_type z1){return z1.get_bmax() < it2->get_bmin();}), act_1.end()); // remove if z1.bmax < z2.bmin
-                bool z2_incd = std::any_of(act_1.begin(), act_1.end(), [&](zone_type z1){return zone_type::includes(z1, *it2);});
-                if(!z2_incd){
-                    return false;
+                if(!covered(*it2)){
+                    return it2;
                 }
                 it2++;
             }
         }
-        while (it2 != zs2.cend() and not act_1.empty()) {
-            act_1.erase( std::remove_if(act_1.begin(), act_1.end(), [&](zone_type z1){return z1.get_bmax() < it2->get_bmin();}), act_1.end()); // remove if z1.bmax < z2.bmin
-            bool z2_incd = std::any_of(act_1.begin(), act_1.end(), [&](zone_type z1){return zone_type::includes(z1, *it2);});
-            if(!z2_incd){
-                return false;
+        while (it2 != zs2.cend()) {
+            if(!covered(*it2)){
+                return it2;
             }
             it2++;
         }
-        return true;
+        return zs2.cend();
     }
 
+    /* Temporaries go to the const reference version, which does not copy its operands */
     static zone_set_type intersection(zone_set_type&& zs1, zone_set_type&& zs2){
-        return zone_set_type::intersection(std::move(zs1), std::move(zs2));
+        return zone_set_type::intersection(static_cast<const zone_set_type&>(zs1), static_cast<const zone_set_type&>(zs2));
     }
 
     static zone_set_type intersection(const zone_set_type& zs1, zone_set_type&& zs2){
-        return zone_set_type::intersection(zs1, std::move(zs2));
+        return zone_set_type::intersection(zs1, static_cast<const zone_set_type&>(zs2));
     }
 
     static zone_set_type intersection(zone_set_type&& zs1, const zone_set_type& zs2){
-        return zone_set_type::intersection(std::move(zs1), zs2);
+        return zone_set_type::intersection(static_cast<const zone_set_type&>(zs1), zs2);
     }
 
 
+    /**
+     *  @brief  Intersection of two zone sets
+     *  @param  zs1  A %zone_set sorted by bmin
+     *  @param  zs2  A %zone_set sorted by bmin
+     *
+     *  A zone whose [bmin, bmax] spans many zones of the operands would stay
+     *  in the active lists of the sweep and be compared with every zone
+     *  pushed after it. Such long zones are kept out of the sweep in a
+     *  %long_zone_index of each operand, which every zone of the other
+     *  operand queries when it is swept. When most zones overlap many others
+     *  the operands are joined through a %block_tree instead, see
+     *  `tree_join_density`.
+     */
     static zone_set_type intersection(const zone_set_type& zs1, const zone_set_type& zs2){
 
+        if(zs1.is_period_list() and zs2.is_period_list()){
+            return period_intersection(zs1, zs2);
+        }
+
+        auto bmin = [](const zone_type& z) -> const value_type& {return z.get_bmin().value;};
+        auto bmax = [](const zone_type& z) -> const value_type& {return z.get_bmax().value;};
+        auto emin = [](const zone_type& z) -> const value_type& {return z.get_emin().value;};
+        auto emax = [](const zone_type& z) -> const value_type& {return z.get_emax().value;};
+
+        std::vector<const value_type*> events = sweep_events(zs1, bmin, zs2, bmin);
+        std::vector<std::size_t> spans1 = event_spans(zs1, events, bmin, bmax);
+        std::vector<std::size_t> spans2 = event_spans(zs2, events, bmin, bmax);
+
+        // Dense on b, and the tree prunes at least half of the pairs on e
+        std::size_t pairs = std::accumulate(spans1.cbegin(), spans1.cend(), std::size_t(0)) +
+                            std::accumulate(spans2.cbegin(), spans2.cend(), std::size_t(0));
+        if(pairs > tree_join_density * events.size() and
+           2 * overlap_pairs(zs1, zs2, emin, emax) < pairs){
+            return intersection_tree_join(zs1, zs2);
+        }
+
+        zone_set_type short1, short2;
+        long_zones long1, long2;
+        bool split1 = split_long_zones(zs1, spans1, bmin, bmax, short1, long1);
+        bool split2 = split_long_zones(zs2, spans2, bmin, bmax, short2, long2);
+
+        return intersection_sweep(split1 ? short1 : zs1, split2 ? short2 : zs2, long1, long2);
+    }
+
+private:
+
+    /* The sweep of `intersection`, the long zones of each operand being given apart */
+    static zone_set_type intersection_sweep(const zone_set_type& zs1, const zone_set_type& zs2,
+                                            const long_zones& long1, const long_zones& long2){
+
         zone_set_type result = zone_set();
 
-        zone_set_type act_1, act_2, act_r, act_r_temp;
+        sweep_scratch& scratch = sweep_scratch::get();
+        Container &act_1 = scratch.act_1, &act_2 = scratch.act_2, &act_r = scratch.act_r, &act_r_temp = scratch.act_r_temp;
+
+        auto combine = [&](const zone_type& z1, const zone_type& z2, const lower_bound_type& front){
+
+            auto kid = zone_type::intersection(z1, z2);
+
+            if( kid.is_nonempty() and 
+                !std::any_of(act_r.begin(), act_r.end(), [&kid](const zone_type& zr){return zone_type::includes(zr, kid);} ))
+            {
+                act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](const zone_type& zr){return zone_type::includes(kid, zr);}), act_r.end());
+                act_r.push_back(kid);
+
+                act_r_temp.clear();
+                for(const auto& zr : act_r){
+                    if( zr.get_bmax() < front){
+                        result.container.push_back(zr);
+                    }
+                    else {
+                        act_r_temp.push_back(zr);
+                    }
+                }
+                std::swap(act_r, act_r_temp);
+            }
+        };
+
+        // Zones of one operand against the long zones of the other
+        auto against_long1 = [&](const zone_type& z2){
+            long1.index.query(z2.get_bmin().value, z2.get_bmax().value, [&](std::size_t i){ combine(long1.zones.container[i], z2, z2.get_bmin()); });
+        };
+        auto against_long2 = [&](const zone_type& z1){
+            long2.index.query(z1.get_bmin().value, z1.get_bmax().value, [&](std::size_t i){ combine(z1, long2.zones.container[i], z1.get_bmin()); });
+        };
+
+        // Long zones in bmin order up to `key`, each against the long zones of the
+        // other operand it starts in, like the sweep against its active list
+        auto lit1 = long1.zones.cbegin();
+        auto lit2 = long2.zones.cbegin();
+        auto long_pairs_until = [&](const lower_bound_type* key){
+            while(lit1 != long1.zones.cend() or lit2 != long2.zones.cend()){
+                bool first = lit2 == long2.zones.cend() or
+                             (lit1 != long1.zones.cend() and lit1->get_bmin() < lit2->get_bmin());
+                const zone_type& z = first ? *lit1 : *lit2;
+                if(key != nullptr and *key < z.get_bmin()){
+                    return;
+                }
+                const value_type& b = z.get_bmin().value;
+                if(first){
+                    long2.index.query(b, b, [&](std::size_t i){ combine(z, long2.zones.container[i], z.get_bmin()); });
+                    lit1++;
+                } else {
+                    long1.index.query(b, b, [&](std::size_t i){ combine(long1.zones.container[i], z, z.get_bmin()); });
+                    lit2++;
+                }
+            }
+        };
 
         // std::sort(zs1.begin(), zs1.end(), earlier_bmin<value_type>());
         // std::sort(zs2.begin(), zs2.end(), earlier_bmin<value_type>());
@@ -443,65 +1335,41 @@ public:
 
         while(it1 != zs1.cend() and it2 != zs2.cend()) {
 
+            // Blocks that end before the other operand resumes and that no active or long zone reaches
+            it1 = skip_blocks(zs1, it1, [&](const block_summary<value_type>& b){
+                return b.bmax < it2->get_bmin().value and ends_before(act_2, b.bmin) and !long2.index.overlaps(b.bmin, b.bmax);});
+            if(it1 == zs1.cend()){
+                break;
+            }
+            it2 = skip_blocks(zs2, it2, [&](const block_summary<value_type>& b){
+                return b.bmax < it1->get_bmin().value and ends_before(act_1, b.bmin) and !long1.index.overlaps(b.bmin, b.bmax);});
+            if(it2 == zs2.cend()){
+                break;
+            }
+
 
             if (it1->get_bmin() < it2->get_bmin()){
+                long_pairs_until(&it1->get_bmin());
                 act_1.push_back(*it1);
-                act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](zone_type z2){return z2.get_bmax() < it1->get_bmin();}), act_2.end());
+                act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](const zone_type& z2){return z2.get_bmax() < it1->get_bmin();}), act_2.end());
 
                 for(const auto& z2 : act_2){
-                    // result.add( zone_type::intersection(*it1, z2));
-
-                    auto kid = zone_type::intersection(*it1, z2);
-
-                    if( kid.is_nonempty() and 
-                        !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);} ))
-                    {
-                        act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                        act_r.push_back(kid);
-
-                        act_r_temp.clear();
-                        for(auto zr : act_r){
-                            if( zr.get_bmax() < it1->get_bmin()){
-                                result.push_back(zr);
-                            }
-                            else {
-                                act_r_temp.push_back(zr);
-                            }
-                        }
-                        act_r = act_r_temp;
-                    }
+                    combine(*it1, z2, it1->get_bmin());
                 }
+                against_long2(*it1);
 
                 it1++;
 
             } else {
 
+                long_pairs_until(&it2->get_bmin());
                 act_2.push_back(*it2);
-                act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](zone_type z1){return z1.get_bmax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
+                act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](const zone_type& z1){return z1.get_bmax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
 
                 for(const auto& z1 : act_1){
-                    // result.add( zone_type::intersection(z1, *it2));
-
-                    auto kid = zone_type::intersection(z1, *it2);
-
-                    if( kid.is_nonempty() and 
-                        !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
-                    {
-                        act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                        act_r.push_back(kid);
-
-                        act_r_temp.clear();
-                        for(auto zr : act_r){
-                            if( zr.get_bmax() < it2->get_bmin()){
-                                result.push_back(zr);
-                            }
-                            else {
-                                act_r_temp.push_back(zr);
-                            }
-                        }
-                        act_r = act_r_temp;
-                    }
+                    combine(z1, *it2, it2->get_bmin());
                 }
+                against_long1(*it2);
 
                 it2++;
             }
@@ -509,145 +1377,362 @@ public:
 
         /// Processing left-overs (if zs1 remains)
         while(it1 != zs1.cend()){
-            act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](zone_type z2){return z2.get_bmax() < it1->get_bmin();}), act_2.end());
+            it1 = skip_blocks(zs1, it1, [&](const block_summary<value_type>& b){
+                return ends_before(act_2, b.bmin) and !long2.index.overlaps(b.bmin, b.bmax);});
+            if(it1 == zs1.cend()){
+                break;
+            }
+            long_pairs_until(&it1->get_bmin());
+            act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](const zone_type& z2){return z2.get_bmax() < it1->get_bmin();}), act_2.end());
 
             for(const auto& z2 : act_2){
-                auto kid = zone_type::intersection(*it1, z2);
-
-                if( kid.is_nonempty() and 
-                    !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
-                {
-                    act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                    act_r.push_back(kid);
-
-                    act_r_temp.clear();
-                    for(const auto& zr : act_r){
-                        if( zr.get_bmax() < it1->get_bmin()){
-                            result.push_back(zr);
-                        }
-                        else {
-                            act_r_temp.push_back(zr);
-                        }
-                    }
-                    // std::cout << result.size() << std::endl;
-
-                    act_r = act_r_temp;
-                }
+                combine(*it1, z2, it1->get_bmin());
             }
+            against_long2(*it1);
             it1++;
         }
 
-
-
         /// Processing left-overs (if zs2 remains)
         while(it2 != zs2.cend()){
-            act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](zone_type z1){return z1.get_bmax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
+            it2 = skip_blocks(zs2, it2, [&](const block_summary<value_type>& b){
+                return ends_before(act_1, b.bmin) and !long1.index.overlaps(b.bmin, b.bmax);});
+            if(it2 == zs2.cend()){
+                break;
+            }
+            long_pairs_until(&it2->get_bmin());
+            act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](const zone_type& z1){return z1.get_bmax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
 
             for(const auto& z1 : act_1){
-                auto kid = zone_type::intersection(z1, *it2);
+                combine(z1, *it2, it2->get_bmin());
+            }
+            against_long1(*it2);
+            it2++;
+        }
+        long_pairs_until(nullptr);
+        for(const auto& zr : act_r){
+            result.container.push_back(zr);
+        }
 
-                if( kid.is_nonempty() and 
-                    !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
+        result.sort_by_bmin();
+        return result;
+    }
+
+    /*
+     *  Intersection as an index join: the smaller operand goes into a
+     *  %block_tree and every zone of the other one, in bmin order, probes it
+     *  with its box. Only pairs whose boxes meet on b, e and d are tried,
+     *  where the sweep tries every pair overlapping on b.
+     */
+    static zone_set_type intersection_tree_join(const zone_set_type& zs1, const zone_set_type& zs2){
+
+        zone_set_type result = zone_set();
+
+        sweep_scratch& scratch = sweep_scratch::get();
+        Container &act_r = scratch.act_r, &act_r_temp = scratch.act_r_temp;
+
+        const zone_set_type& indexed = (zs1.size() < zs2.size()) ? zs1 : zs2;
+        const zone_set_type& probes = (zs1.size() < zs2.size()) ? zs2 : zs1;
+        block_tree<value_type> tree(indexed.cbegin(), indexed.cend());
+
+        for(const auto& zp : probes.container){
+            const block_summary<value_type> box{
+                zp.get_bmin().value, zp.get_bmax().value,
+                zp.get_emin().value, zp.get_emax().value,
+                zp.get_dmin().value, zp.get_dmax().value};
+
+            tree.query(box, [&](std::size_t k){
+
+                auto kid = zone_type::intersection(zp, indexed.container[k]);
+
+                if( kid.is_nonempty() and
+                    !std::any_of(act_r.begin(), act_r.end(), [&kid](const zone_type& zr){return zone_type::includes(zr, kid);}))
                 {
-                    act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
+                    act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](const zone_type& zr){return zone_type::includes(kid, zr);}), act_r.end());
                     act_r.push_back(kid);
 
                     act_r_temp.clear();
                     for(const auto& zr : act_r){
-                        if( zr.get_bmax() < it2->get_bmin()){
-                            result.push_back(zr);
+                        if( zr.get_bmax() < zp.get_bmin()){
+                            result.container.push_back(zr);
                         }
                         else {
                             act_r_temp.push_back(zr);
                         }
                     }
-                    act_r = act_r_temp;
+                    std::swap(act_r, act_r_temp);
                 }
-            }
-            it2++;
+            });
         }
         for(const auto& zr : act_r){
-            result.push_back(zr);
+            result.container.push_back(zr);
         }
 
         result.sort_by_bmin();
         return result;
     }
 
-    static zone_set_type concatenation(const zone_set_type& _zs1, const zone_set_type& zs2){
+public:
 
-        zone_set_type result = zone_set();
+    /**
+     *  @brief  Intersection on several threads
+     *  @param  zs1  A %zone_set sorted by bmin
+     *  @param  zs2  A %zone_set sorted by bmin
+     *  @param  num_threads  Number of threads, `0` for all hardware threads
+     *  @return Same %zone_set as `intersection(zs1, zs2)`
+     *
+     *  The bmin axis is cut at quantiles of both inputs so that every chunk
+     *  holds about as many zones. A zone is swept in the chunk of its bmin and
+     *  replicated into the following chunks its [bmin, bmax] reaches. A chunk
+     *  keeps the intersections whose bmin falls inside it, so each result is
+     *  produced exactly once and the chunk results are concatenated in order.
+     */
+    static zone_set_type intersection_parallel(const zone_set_type& zs1, const zone_set_type& zs2, unsigned num_threads = 0){
+
+        if(num_threads == 0){
+            num_threads = hardware_threads();
+        }
+        if(num_threads <= 1 or zs1.size() + zs2.size() < 2 * num_threads or
+           (zs1.is_period_list() and zs2.is_period_list())){
+            return intersection(zs1, zs2);
+        }
 
-        zone_set_type act_1, act_2, act_r, act_r_temp;
+        const std::size_t k = num_threads;
+        const std::size_t n1 = zs1.size(), n2 = zs2.size();
+
+        /* Cut j is the bmin at rank j * (n1 + n2) / k of the merged inputs */
+        auto bmin1 = [&](std::size_t i){ return zs1.container[i].get_bmin().value; };
+        auto bmin2 = [&](std::size_t i){ return zs2.container[i].get_bmin().value; };
+
+        std::vector<value_type> cuts;
+        for(std::size_t j = 1; j < k; j++){
+            std::size_t r = j * (n1 + n2) / k;
+            std::size_t lo = (r > n2) ? r - n2 : 0, hi = std::min(r, n1);
+            while(lo < hi){
+                std::size_t i = (lo + hi) / 2;
+                if(bmin2(r - i - 1) > bmin1(i)){ lo = i + 1; } else { hi = i; }
+            }
+            if(lo < n1 and (r - lo >= n2 or !(bmin2(r - lo) < bmin1(lo)))){
+                cuts.push_back(bmin1(lo));
+            } else {
+                cuts.push_back(bmin2(r - lo));
+            }
+        }
+
+        /* chunk_of(v) is the chunk whose range [cuts[j-1], cuts[j]) holds v */
+        auto chunk_of = [&](const value_type& v){
+            return static_cast<std::size_t>(std::upper_bound(cuts.begin(), cuts.end(), v) - cuts.begin());
+        };
+
+        /* Chunk borders of an input, and replicas of its zones reaching later chunks */
+        auto distribute = [&](const zone_set_type& zs, std::vector<std::size_t>& borders, std::vector<std::vector<zone_set_type>>& replicas){
+            borders.assign(1, 0);
+            for(std::size_t j = 1; j < k; j++){
+                borders.push_back(std::lower_bound(zs.container.begin() + borders.back(), zs.container.end(), cuts[j - 1],
+                    [](const zone_type& z, const value_type& v){ return z.get_bmin().value < v; }) - zs.container.begin());
+            }
+            borders.push_back(zs.size());
+
+            replicas.assign(k, std::vector<zone_set_type>(k));
+            parallel_for(k, num_threads, [&](std::size_t first, std::size_t last, unsigned){
+                for(std::size_t i = first; i < last; i++){
+                    for(std::size_t p = borders[i]; p < borders[i + 1]; p++){
+                        const zone_type& z = zs.container[p];
+                        std::size_t reach = std::min(chunk_of(z.get_bmax().value), k - 1);
+                        for(std::size_t j = i + 1; j <= reach; j++){
+                            replicas[i][j].push_back(z);
+                        }
+                    }
+                }
+            });
+        };
+
+        std::vector<std::size_t> borders1, borders2;
+        std::vector<std::vector<zone_set_type>> replicas1, replicas2;
+        distribute(zs1, borders1, replicas1);
+        distribute(zs2, borders2, replicas2);
+
+        /*
+         *  A result is included in another only if its bmin is not smaller, so
+         *  results of later chunks cannot include those of earlier ones, and the
+         *  pair of any including result from an earlier chunk is also swept here.
+         *  The chunk results are thus already maximal and ordered by bmin.
+         */
+        std::vector<zone_set_type> results(k);
+        parallel_for(k, num_threads, [&](std::size_t first, std::size_t last, unsigned){
+            for(std::size_t j = first; j < last; j++){
+                zone_set_type in1, in2;
+                std::size_t size1 = borders1[j + 1] - borders1[j], size2 = borders2[j + 1] - borders2[j];
+                for(std::size_t i = 0; i < j; i++){
+                    size1 += replicas1[i][j].size();
+                    size2 += replicas2[i][j].size();
+                }
+                in1.container.reserve(size1);
+                in2.container.reserve(size2);
+                for(std::size_t i = 0; i < j; i++){
+                    in1.insert(in1.end(), replicas1[i][j].cbegin(), replicas1[i][j].cend());
+                    in2.insert(in2.end(), replicas2[i][j].cbegin(), replicas2[i][j].cend());
+                }
+                in1.insert(in1.end(), zs1.cbegin() + borders1[j], zs1.cbegin() + borders1[j + 1]);
+                in2.insert(in2.end(), zs2.cbegin() + borders2[j], zs2.cbegin() + borders2[j + 1]);
+
+                /* Sorted by bmin: results of other chunks form a prefix and a suffix */
+                results[j] = intersection(in1, in2);
+                auto& r = results[j].container;
+                r.erase(std::partition_point(r.begin(), r.end(), [&](const zone_type& z){ return chunk_of(z.get_bmin().value) <= j; }), r.end());
+                r.erase(r.begin(), std::partition_point(r.begin(), r.end(), [&](const zone_type& z){ return chunk_of(z.get_bmin().value) < j; }));
+            }
+        });
+
+        zone_set_type result;
+        std::size_t total = 0;
+        for(const auto& r : results){
+            total += r.size();
+        }
+        result.container.reserve(total);
+        for(const auto& r : results){
+            result.container.insert(result.container.end(), r.cbegin(), r.cend());
+        }
+        return result;
+    }
+
+    /**
+     *  @brief  Concatenation of two zone sets
+     *  @param  zs1  Left %zone_set
+     *  @param  zs2  Right %zone_set, sorted by bmin
+     *
+     *  Left zones are swept by [emin, emax] and right ones by [bmin, bmax].
+     *  As in `intersection`, zones whose interval spans many zones of the
+     *  operands are queried through a %long_zone_index instead.
+     */
+    static zone_set_type concatenation(const zone_set_type& _zs1, const zone_set_type& zs2){
 
         // Could be better?
         auto zs1 = zone_set_type(_zs1);
-        std::sort(zs1.begin(), zs1.end(), earlier_emin<value_type>());
-        // std::sort(zs2.begin(), zs2.end(), earlier_bmin<value_type>());
+        zs1.sort_by_emin();
+
+        auto bmin = [](const zone_type& z) -> const value_type& {return z.get_bmin().value;};
+        auto bmax = [](const zone_type& z) -> const value_type& {return z.get_bmax().value;};
+        auto emin = [](const zone_type& z) -> const value_type& {return z.get_emin().value;};
+        auto emax = [](const zone_type& z) -> const value_type& {return z.get_emax().value;};
+
+        std::vector<const value_type*> events = sweep_events(zs1, emin, zs2, bmin);
+        zone_set_type short1, short2;
+        long_zones long1, long2;
+        bool split1 = split_long_zones(zs1, event_spans(zs1, events, emin, emax), emin, emax, short1, long1);
+        bool split2 = split_long_zones(zs2, event_spans(zs2, events, bmin, bmax), bmin, bmax, short2, long2);
+
+        return concatenation_emin_sweep(split1 ? short1 : zs1, split2 ? short2 : zs2, long1, long2);
+    }
+
+private:
+
+    /*
+     *  The sweep of `concatenation`, with `zs1` sorted by emin. Long left zones
+     *  are indexed on [emin, emax] and long right ones on [bmin, bmax].
+     */
+    static zone_set_type concatenation_emin_sweep(const zone_set_type& zs1, const zone_set_type& zs2,
+                                                  const long_zones& long1, const long_zones& long2){
+
+        zone_set_type result = zone_set();
+
+        sweep_scratch& scratch = sweep_scratch::get();
+        Container &act_1 = scratch.act_1, &act_2 = scratch.act_2, &act_r = scratch.act_r, &act_r_temp = scratch.act_r_temp;
+
+        auto combine = [&](const zone_type& z1, const zone_type& z2, const lower_bound_type& front){
+
+            if(!zone_type::meets(z1, z2)){
+                return;
+            }
+
+            auto kid = zone_type::concatenation(z1, z2);
+
+            if( kid.is_nonempty() and 
+                !std::any_of(act_r.begin(), act_r.end(), [&kid](const zone_type& zr){return zone_type::includes(zr, kid);}))
+            {
+                act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](const zone_type& zr){return zone_type::includes(kid, zr);}), act_r.end());
+                act_r.push_back(kid);
+
+                act_r_temp.clear();
+                for(const auto& zr : act_r){
+                    if( zr.get_bmax() < front){
+                        result.container.push_back(zr);
+                    }
+                    else {
+                        act_r_temp.push_back(zr);
+                    }
+                }
+                std::swap(act_r, act_r_temp);
+            }
+        };
+
+        // Zones of one operand against the long zones of the other
+        auto against_long1 = [&](const zone_type& z2){
+            long1.index.query(z2.get_bmin().value, z2.get_bmax().value, [&](std::size_t i){ combine(long1.zones.container[i], z2, z2.get_bmin()); });
+        };
+        auto against_long2 = [&](const zone_type& z1){
+            long2.index.query(z1.get_emin().value, z1.get_emax().value, [&](std::size_t i){ combine(z1, long2.zones.container[i], z1.get_bmin()); });
+        };
+
+        // Long zones in order of emin (left) and bmin (right) up to `key`, each
+        // against the long zones of the other operand it starts in
+        auto lit1 = long1.zones.cbegin();
+        auto lit2 = long2.zones.cbegin();
+        auto long_pairs_until = [&](const lower_bound_type* key){
+            while(lit1 != long1.zones.cend() or lit2 != long2.zones.cend()){
+                bool first = lit2 == long2.zones.cend() or
+                             (lit1 != long1.zones.cend() and lit1->get_emin() < lit2->get_bmin());
+                const lower_bound_type& at = first ? lit1->get_emin() : lit2->get_bmin();
+                if(key != nullptr and *key < at){
+                    return;
+                }
+                if(first){
+                    long2.index.query(at.value, at.value, [&](std::size_t i){ combine(*lit1, long2.zones.container[i], lit1->get_bmin()); });
+                    lit1++;
+                } else {
+                    long1.index.query(at.value, at.value, [&](std::size_t i){ combine(long1.zones.container[i], *lit2, lit2->get_bmin()); });
+                    lit2++;
+                }
+            }
+        };
 
         auto it1 = zs1.cbegin();
         auto it2 = zs2.cbegin();
 
+        // Blocks of zs2 that no left zone, active, long or to come, can meet
+        auto unmet = [&](const block_summary<value_type>& b){
+            return std::all_of(act_1.cbegin(), act_1.cend(), [&b](const zone_type& z1){return z1.get_emax().value < b.bmin;}) and
+                   !long1.index.overlaps(b.bmin, b.bmax);
+        };
+
         while(it1 != zs1.cend() and it2 != zs2.cend()) {
 
+            it2 = skip_blocks(zs2, it2, [&](const block_summary<value_type>& b){return b.bmax < it1->get_emin().value and unmet(b);});
+            if(it2 == zs2.cend()){
+                break;
+            }
+
             if (it1->get_emin() < it2->get_bmin()){
+                long_pairs_until(&it1->get_emin());
                 act_1.push_back(*it1);
-                act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](zone_type z2){return z2.get_bmax() < it1->get_emin();}), act_2.end());
+                act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](const zone_type& z2){return z2.get_bmax() < it1->get_emin();}), act_2.end());
 
                 for(const auto& z2 : act_2){
-                    // result.add( zone_type::concatenation(*it1, z2));
-
-                    auto kid = zone_type::concatenation(*it1, z2);
-
-                    if( kid.is_nonempty() and 
-                        !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
-                    {
-                        act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                        act_r.push_back(kid);
-
-                        act_r_temp.clear();
-                        for(auto zr : act_r){
-                            if( zr.get_bmax() < it1->get_bmin()){
-                                result.push_back(zr);
-                            }
-                            else {
-                                act_r_temp.push_back(zr);
-                            }
-                        }
-                        act_r = act_r_temp;
-                    }
+                    combine(*it1, z2, it1->get_bmin());
                 }
+                against_long2(*it1);
 
                 it1++;
 
             } else {
 
+                long_pairs_until(&it2->get_bmin());
                 act_2.push_back(*it2);
-                act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](zone_type z1){return z1.get_emax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
+                act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](const zone_type& z1){return z1.get_emax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
 
                 for(const auto& z1 : act_1){
-                    // result.add( zone_type::concatenation(z1, *it2));
-
-                    auto kid = zone_type::concatenation(z1, *it2);
-
-                    if( kid.is_nonempty() and 
-                        !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
-                    {
-                        act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                        act_r.push_back(kid);
-
-                        act_r_temp.clear();
-                        for(auto zr : act_r){
-                            if( zr.get_bmax() < it2->get_bmin()){
-                                result.push_back(zr);
-                            }
-                            else {
-                                act_r_temp.push_back(zr);
-                            }
-                        }
-                        act_r = act_r_temp;
-                    }
+                    combine(z1, *it2, it2->get_bmin());
                 }
+                against_long1(*it2);
 
                 it2++;
             }
@@ -655,94 +1740,273 @@ public:
 
         /// Processing left-overs (if zs1 remains)
         while(it1 != zs1.cend()){
-            act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](zone_type z2){return z2.get_bmax() < it1->get_bmin();}), act_2.end());
+            long_pairs_until(&it1->get_emin());
+            act_2.erase(std::remove_if(act_2.begin(), act_2.end(), [&](const zone_type& z2){return z2.get_bmax() < it1->get_emin();}), act_2.end());
 
             for(const auto& z2 : act_2){
-                auto kid = zone_type::concatenation(*it1, z2);
-
-                if( kid.is_nonempty() and 
-                    !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
-                {
-                    act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                    act_r.push_back(kid);
-
-                    act_r_temp.clear();
-                    for(const auto& zr : act_r){
-                        if( zr.get_bmax() < it1->get_bmin()){
-                            result.push_back(zr);
-                        }
-                        else {
-                            act_r_temp.push_back(zr);
-                        }
-                    }
-                    act_r = act_r_temp;
-                }
+                combine(*it1, z2, it1->get_bmin());
             }
+            against_long2(*it1);
             it1++;
         }
 
         /// Processing left-overs (if zs2 remains)
         while(it2 != zs2.cend()){
-            act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](zone_type z1){return z1.get_emax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
+            it2 = skip_blocks(zs2, it2, unmet);
+            if(it2 == zs2.cend()){
+                break;
+            }
+            long_pairs_until(&it2->get_bmin());
+            act_1.erase(std::remove_if(act_1.begin(), act_1.end(), [&](const zone_type& z1){return z1.get_emax() < it2->get_bmin();}), act_1.end()); // remove if z1.emax < z2.bmin
 
             for(const auto& z1 : act_1){
-                auto kid = zone_type::concatenation(z1, *it2);
+                combine(z1, *it2, it2->get_bmin());
+            }
+            against_long1(*it2);
+            it2++;
+        }
+        long_pairs_until(nullptr);
+        for(const auto& zr : act_r){
+            result.container.push_back(zr);
+        }
 
-                if( kid.is_nonempty() and 
-                    !std::any_of(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(zr, kid);}))
-                {
-                    act_r.erase( std::remove_if(act_r.begin(), act_r.end(), [&kid](zone_type &zr){return zone_type::includes(kid, zr);}), act_r.end());
-                    act_r.push_back(kid);
+        result.sort_by_bmin();
+        return result;
+    }
 
-                    act_r_temp.clear();
-                    for(const auto& zr : act_r){
-                        if( zr.get_bmax() < it2->get_bmin()){
-                            result.push_back(zr);
-                        }
-                        else {
-                            act_r_temp.push_back(zr);
-                        }
+public:
+
+    /**
+     *  @brief  Concatenation on several threads
+     *  @param  zs1  Left %zone_set
+     *  @param  zs2  Right %zone_set, sorted by bmin
+     *  @param  num_threads  Number of threads, `0` for all hardware threads
+     *  @return %zone_set with the same periods as `concatenation(zs1, zs2)`
+     *
+     *  The axis of meeting points is cut at quantiles of left emins and right
+     *  bmins. A left zone goes to every chunk its [emin, emax] reaches and a
+     *  right zone to every chunk its [bmin, bmax] reaches; a pair is only
+     *  combined in the chunk holding its earliest meeting point, the larger
+     *  of z1.emin and z2.bmin. Chunks are swept on their own thread and their
+     *  results filtered for dominance with `filter_parallel`.
+     */
+    static zone_set_type concatenation_parallel(const zone_set_type& zs1, const zone_set_type& zs2, unsigned num_threads = 0){
+
+        if(num_threads == 0){
+            num_threads = hardware_threads();
+        }
+        if(num_threads <= 1 or zs1.size() + zs2.size() < 2 * num_threads){
+            return concatenation(zs1, zs2);
+        }
+
+        const std::size_t k = num_threads;
+
+        /* Cuts at quantiles of a strided sample of the meeting points */
+        std::vector<value_type> sample;
+        std::size_t stride1 = std::max<std::size_t>(1, zs1.size() / (64 * k));
+        std::size_t stride2 = std::max<std::size_t>(1, zs2.size() / (64 * k));
+        for(std::size_t i = 0; i < zs1.size(); i += stride1){
+            sample.push_back(zs1.container[i].get_emin().value);
+        }
+        for(std::size_t i = 0; i < zs2.size(); i += stride2){
+            sample.push_back(zs2.container[i].get_bmin().value);
+        }
+        std::sort(sample.begin(), sample.end());
+
+        std::vector<value_type> cuts;
+        for(std::size_t j = 1; j < k; j++){
+            cuts.push_back(sample[j * sample.size() / k]);
+        }
+
+        auto chunk_of = [&](const value_type& v){
+            return static_cast<std::size_t>(std::upper_bound(cuts.begin(), cuts.end(), v) - cuts.begin());
+        };
+
+        /* parts[i][j]: zones of source chunk i that reach chunk j, in source order */
+        typedef std::vector<std::vector<zone_set_type>> parts_type;
+        auto distribute = [&](const zone_set_type& zs, bool left, parts_type& parts){
+            std::vector<std::size_t> borders = chunk_borders(zs.size(), num_threads);
+            parts.assign(borders.size() - 1, std::vector<zone_set_type>(k));
+            parallel_for(zs.size(), num_threads, [&](std::size_t first, std::size_t last, unsigned i){
+                for(std::size_t p = first; p < last; p++){
+                    const zone_type& z = zs.container[p];
+                    std::size_t from = chunk_of(left ? z.get_emin().value : z.get_bmin().value);
+                    std::size_t to = std::min(chunk_of(left ? z.get_emax().value : z.get_bmax().value), k - 1);
+                    for(std::size_t j = from; j <= to; j++){
+                        parts[i][j].push_back(z);
                     }
-                    act_r = act_r_temp;
                 }
+            });
+        };
+
+        parts_type parts1, parts2;
+        distribute(zs1, true, parts1);
+        distribute(zs2, false, parts2);
+
+        std::vector<zone_set_type> results(k);
+        parallel_for(k, num_threads, [&](std::size_t first, std::size_t last, unsigned){
+            for(std::size_t j = first; j < last; j++){
+                zone_set_type in1, in2;
+                std::size_t size1 = 0, size2 = 0;
+                for(const auto& p : parts1){ size1 += p[j].size(); }
+                for(const auto& p : parts2){ size2 += p[j].size(); }
+                in1.container.reserve(size1);
+                in2.container.reserve(size2);
+                results[j].container.reserve(std::max(size1, size2));
+                for(std::size_t i = 0; i < parts1.size(); i++){
+                    in1.insert(in1.end(), parts1[i][j].cbegin(), parts1[i][j].cend());
+                }
+                for(std::size_t i = 0; i < parts2.size(); i++){
+                    in2.insert(in2.end(), parts2[i][j].cbegin(), parts2[i][j].cend());
+                }
+                in1.sort_by_emin();
+
+                concatenation_sweep(in1, in2,
+                    [&](const zone_type& z1, const zone_type& z2){
+                        return chunk_of(std::max(z1.get_emin().value, z2.get_bmin().value)) == j;
+                    },
+                    [](const zone_type& z1, const zone_type& z2){
+                        return zone_type::concatenation(z1, z2);
+                    },
+                    [](const zone_type& z1, const zone_type& z2){
+                        return z1.get_emax() < z2.get_bmin();
+                    },
+                    results[j]);
             }
-            it2++;
+        });
+
+        return filter_parallel(results, num_threads);
+    }
+
+    /**
+     *  @brief  Concatenation followed by duration restriction
+     *  @param  zs1   Left %zone_set
+     *  @param  zs2   Right %zone_set, sorted by bmin
+     *  @param  dmin  Lower bound on the duration of the results
+     *  @param  dmax  Upper bound on the duration of the results
+     *  @return %zone_set
+     *
+     *  Same as `duration_restriction(concatenation(zs1, zs2), dmin, dmax)` but
+     *  the duration window is applied inside the sweep: a left zone leaves the
+     *  active list once the current right zones begin too late to complete
+     *  a period shorter than dmax, and pairs that cannot meet the window are
+     *  skipped without building their concatenation.
+     */
+    static zone_set_type concatenation_duration_restriction(
+        const zone_set_type& _zs1,
+        const zone_set_type& zs2,
+        const lower_bound_type& dmin,
+        const upper_bound_type& dmax){
+
+        zone_set_type result = zone_set();
+
+        if(_zs1.empty() or zs2.empty()){
+            return result;
         }
-        for(const auto& zr : act_r){
-            result.push_back(zr);
+
+        auto zs1 = zone_set_type(_zs1);
+        zs1.sort_by_emin();
+
+        /* Shortest possible right part, used to bound the duration of any result */
+        lower_bound_type dmin2 = zs2.cbegin()->get_dmin();
+        for(const auto& z2 : zs2){
+            if(lower_bound_type::includes(z2.get_dmin(), dmin2)){
+                dmin2 = z2.get_dmin();
+            }
         }
 
+        concatenation_sweep(zs1, zs2,
+            [&](const zone_type& z1, const zone_type& z2){
+                return bound_type::is_valid_interval(lower_bound_type::add(z1.get_dmin(), z2.get_dmin()), dmax) and
+                       bound_type::is_valid_interval(dmin, upper_bound_type::add(z1.get_dmax(), z2.get_dmax()));
+            },
+            [&](const zone_type& z1, const zone_type& z2){
+                return zone_type::concatenation(z1, z2, dmin, dmax);
+            },
+            /* z1 can no longer contribute once z2.bmin - z1.bmax + dmin2 exceeds dmax */
+            [&](const zone_type& z1, const zone_type& z2){
+                return z1.get_emax() < z2.get_bmin() or
+                       !bound_type::is_valid_interval(
+                            lower_bound_type::add(lower_bound_type::add(z2.get_bmin(), z1.get_bmax()), dmin2), dmax);
+            },
+            result);
+
         result.sort_by_bmin();
-        return result;
+        return zone_set_type::filter(result);
     }
 
-    static zone_set_type transitive_closure(const zone_set_type& zs){
+    /**
+     *  @brief  Concatenation followed by duration restriction to (dmin, dmax]
+     */
+    static zone_set_type concatenation_duration_restriction(
+        const zone_set_type& zs1,
+        const zone_set_type& zs2,
+        const value_type dmin,
+        const value_type dmax){
 
-        auto result = zone_set();
+        return concatenation_duration_restriction(zs1, zs2, lower_bound_type::open(dmin), upper_bound_type::closed(dmax));
+    }
+
+    static zone_set_type transitive_closure(const zone_set_type& zs){
+        zone_interner<zone_type> table;
+        return transitive_closure(zs, table);
+    }
 
-        zone_set_type zplus = zs;
-        zone_set_type zlast = zs;
+    /**
+     *  @brief  Transitive closure that interns the zones it generates
+     *  @param  zs     A %zone_set
+     *  @param  table  Zones seen so far, whose stats give the duplicate rate
+     *
+     *  Each round only extends the zones that are new to `table`: the
+     *  others were extended in an earlier round, or are covered by a zone
+     *  that was.
+     */
+    static zone_set_type transitive_closure(const zone_set_type& zs, zone_interner<zone_type>& table){
 
-        zone_set_type znext;
+        zone_set_type zplus = set_union(zs, zone_set_type(), table);
+        zone_set_type zlast = zplus;
 
-        znext = concatenation(zlast, zs);
+        zone_set_type znext = concatenation(zlast, zs);
         while(not includes(zplus, znext)){
-            // std::cout << znext << zplus << includes(zplus, znext) << std::endl;                zlast = znext;
-            zplus = set_union(zplus, znext);
-            znext.clear();
-
+            zlast = fresh_zones(znext, table);
+            zplus = set_union(zplus, zlast);
             znext = concatenation(zlast, zs);
         }
 
-    return zplus;
-}
+        return zplus;
+    }
 
     static zone_set_type set_union(const zone_set_type& zs1, const zone_set_type& zs2){
 
+        if(zs1.is_period_list() and zs2.is_period_list()){
+            return period_union(zs1, zs2);
+        }
+
         auto result = zone_set();
 
-        result.insert( result.end(), zs1.cbegin(), zs1.cend());
-        result.insert( result.end(), zs2.cbegin(), zs2.cend());
+        result.container.insert(result.container.end(), zs1.cbegin(), zs1.cend());
+        result.container.insert(result.container.end(), zs2.cbegin(), zs2.cend());
+
+        return zone_set_type::filter(result);
+    }
+
+    /**
+     *  @brief  Union that drops the zones already interned in `table`
+     *
+     *  Exact duplicates, within the operands or of zones interned by an
+     *  earlier call, are removed by hashing before the inclusion filter.
+     *  Zones interned earlier are taken as covered by an earlier result,
+     *  so a table is only shared by the unions of one evaluation.
+     */
+    static zone_set_type set_union(const zone_set_type& zs1, const zone_set_type& zs2, zone_interner<zone_type>& table){
+
+        auto result = fresh_zones(zs1, table);
+        for(const auto& z : zs2.container){
+            if(table.insert(z)){
+                result.container.push_back(z);
+            }
+        }
+        result.sort_by_bmin();
 
         return zone_set_type::filter(result);
     }
@@ -859,7 +2123,7 @@ public:
 
         result.add(zone_type::universal());
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             auto nzs = zone_set_type::complementation(z);
             result = zone_set_type::intersection(result, nzs);
         }
@@ -880,7 +2144,7 @@ public:
 
         auto result = zone_set(zs1);
 
-        for(auto z : zs2){
+        for(const auto& z : zs2){
             auto nzs = zone_set_type::complementation(z);
             result = zone_set_type::intersection(result, nzs);
         }
@@ -897,11 +2161,11 @@ public:
      *
      *  Returns the result of operation <A>_(a, b) on the zone set given 
      */
-    static zone_set_type diamond_meets(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type diamond_meets(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
 
         zone_set_type result = zone_set();
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             result.add(zone_type::make(
                 z.get_emin(),
                 z.get_emax(),
@@ -912,7 +2176,7 @@ public:
             ));
         }
 
-        return zone_set<T>::filter(result);
+        return zone_set_type::filter(result);
     }
 
 
@@ -926,11 +2190,11 @@ public:
      *
      *  Returns the result of operation <Ai>_(a, b] on the zone set given 
      */
-    static zone_set_type diamond_met_by(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type diamond_met_by(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         
         zone_set_type result = zone_set();
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             result.add(zone_type::make(
                 lower_bound_type::unbounded(),
                 upper_bound_type::unbounded(),               
@@ -941,7 +2205,7 @@ public:
             ));
         }
 
-        return zone_set<T>::filter(result);
+        return zone_set_type::filter(result);
     }
 
 
@@ -955,11 +2219,11 @@ public:
      *
      *  Returns the result of operation <Ai>_(a, b) on the zone set given 
      */
-    static zone_set_type diamond_started_by(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type diamond_started_by(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         
         zone_set_type result = zone_set();
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             result.add(zone_type::make(
                 z.get_bmin(),
                 z.get_bmax(),
@@ -970,7 +2234,7 @@ public:
             ));
         }
 
-        return zone_set<T>::filter(result);
+        return zone_set_type::filter(result);
     }
 
 
@@ -983,11 +2247,11 @@ public:
      *
      *  Returns the result of operation <Ai>_(a, b] on the zone set given 
      */
-    static zone_set_type diamond_starts(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type diamond_starts(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         
         zone_set_type result = zone_set();
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             result.add(zone_type::make(
                 z.get_bmin(),
                 z.get_bmax(),
@@ -998,7 +2262,7 @@ public:
             ));
         }
 
-        return zone_set<T>::filter(result);
+        return zone_set_type::filter(result);
     }
 
 
@@ -1012,11 +2276,11 @@ public:
      *
      *  Returns the result of operation <Ai>_(a, b] on the zone set given 
      */
-    static zone_set_type diamond_finished_by(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type diamond_finished_by(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         
         zone_set_type result = zone_set();
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             result.add(zone_type::make(
                 lower_bound_type::add(z.get_bmin(), ubound),
                 upper_bound_type::add(z.get_bmax(), lbound),        
@@ -1027,7 +2291,7 @@ public:
             ));
         }
 
-        return zone_set<T>::filter(result);
+        return zone_set_type::filter(result);
     }
 
 
@@ -1041,11 +2305,11 @@ public:
      *
      *  Returns the result of operation <Ai>_(a, b] on the zone set given 
      */
-    static zone_set_type diamond_finishes(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type diamond_finishes(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         
         zone_set_type result = zone_set();
 
-        for(auto z : zs){
+        for(const auto& z : zs){
             result.add(zone_type::make(
                 lower_bound_type::add(z.get_bmin(), lbound), 
                 upper_bound_type::add(z.get_bmax(), ubound),         
@@ -1059,7 +2323,7 @@ public:
             ));
         }
 
-        return zone_set<T>::filter(result);
+        return zone_set_type::filter(result);
     }
 
     static zone_set_type diamond_meets(const zone_set_type& zs, const value_type a, const value_type b){
@@ -1104,22 +2368,22 @@ public:
     // Note end:
 
 
-    static zone_set_type box_meets(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type box_meets(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         return zone_set_type::complementation(diamond_meets(zone_set_type::complementation(zs), lbound, ubound));
     }
-    static zone_set_type box_met_by(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type box_met_by(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         return zone_set_type::complementation(diamond_met_by(zone_set_type::complementation(zs), lbound, ubound));
     }
-    static zone_set_type box_starts(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type box_starts(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         return zone_set_type::complementation(diamond_starts(zone_set_type::complementation(zs), lbound, ubound));
     }
-    static zone_set_type box_started_by(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type box_started_by(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         return zone_set_type::complementation(diamond_started_by(zone_set_type::complementation(zs), lbound, ubound));
     }
-    static zone_set_type box_finishes(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type box_finishes(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         return zone_set_type::complementation(diamond_finishes(zone_set_type::complementation(zs), lbound, ubound));
     }
-    static zone_set_type box_finished_by(const zone_set_type& zs, const lower_bound_type lbound, const upper_bound_type ubound){
+    static zone_set_type box_finished_by(const zone_set_type& zs, const lower_bound_type& lbound, const upper_bound_type& ubound){
         return zone_set_type::complementation(diamond_finished_by(zone_set_type::complementation(zs), lbound, ubound));
     }
 
@@ -1167,6 +2431,13 @@ public:
 };
 
 
+/*
+ *  Zone set of `closed_zone`s, for robustness computations and other
+ *  pipelines that never need strict bounds.
+ */
+template <class T>
+using closed_zone_set = zone_set<T, std::vector< closed_zone<T> > >;
+
 template <>
 zone_set<mpq_class> zone_set<mpq_class>::diamond_meets_string(const zone_set<mpq_class>& zs,
         const std::string &a, const std::string &b){
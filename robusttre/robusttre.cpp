@@ -1,11 +1,25 @@
 #include <ppl.hh>
 #include <gmpxx.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 
 #include "bound.hpp"
 #include "zone.hpp"
 #include "zone_set.hpp"
 #include "utils.hpp"
+#include "ingestion.hpp"
+#include "serialization.hpp"
+#include "external.hpp"
+#include "online.hpp"
+#include "plan.hpp"
+#include "tre_parser.hpp"
+#include "statistics.hpp"
+#include "planner.hpp"
+#include "executor.hpp"
+#include "batch.hpp"
+#include "op_cache.hpp"
+#include "rank.hpp"
 
 using namespace Parma_Polyhedra_Library;
 using namespace Parma_Polyhedra_Library::IO_Operators;
@@ -17,13 +31,13 @@ int add(int i, int j) {
 /* Fully accurate when zones don't intersect */
 /* Gives a conservative estimate otherwise */
 template <typename T>
-timedrel::zone_set<T> time_robust_match_translation(timedrel::zone_set<T> &zs_in, T r_lbound){
+timedrel::zone_set<T> time_robust_match_translation(const timedrel::zone_set<T> &zs_in, T r_lbound){
     timedrel::zone_set<T> zs_res;
 
     Variable x(0),y(1),delta(2);
 
     /* Convert zones to robustness polyhedra */
-    for(auto z : zs_in){
+    for(const auto& z : zs_in){
         Constraint_System cs;
         mpq_class x_min(z.get_bmin().value);
         mpq_class x_max(z.get_bmax().value);
@@ -92,13 +106,27 @@ timedrel::zone_set<T> time_robust_match_translation(timedrel::zone_set<T> &zs_in
 /* Fully accurate when zones don't intersect */
 /* Gives a conservative estimate otherwise */
 template <typename T>
-T get_time_robustness_translation(timedrel::zone_set<T> &zs_in, T l, T u){
+T get_time_robustness_translation(const timedrel::zone_set<T> &zs_in, T l, T u){
     Variable x(0),y(1),delta(2);
 
     T rob_value = 0;
 
+    /* Zones of a block whose hull misses (l, u) cannot contain it */
+    const auto* index = zs_in.get_block_index();
+    auto misses = [&](const timedrel::block_summary<T>& b){
+        return l < b.bmin or b.bmax < l or u < b.emin or b.emax < u or u - l < b.dmin or b.dmax < u - l;
+    };
+
     /* Convert zones to robustness polyhedra */
-    for(auto z : zs_in){
+    for(auto it = zs_in.cbegin(); it != zs_in.cend(); it++){
+        if(index != nullptr){
+            std::size_t k = it - zs_in.cbegin();
+            if(k % index->block_size == 0 and misses(index->blocks[k / index->block_size])){
+                it += std::min(index->block_size, zs_in.size() - k) - 1;
+                continue;
+            }
+        }
+        const auto& z = *it;
         Constraint_System cs;
         mpq_class x_min(z.get_bmin().value);
         mpq_class x_max(z.get_bmax().value);
@@ -145,33 +173,33 @@ T get_time_robustness_translation(timedrel::zone_set<T> &zs_in, T l, T u){
 }
 
 template <typename T>
-timedrel::zone_set<T> make_zone_set_boundaries_closed(timedrel::zone_set<T> &zs_in){
-    timedrel::zone_set<T> zs_res;
-    for(auto z : zs_in){
+timedrel::closed_zone_set<T> make_zone_set_boundaries_closed(const timedrel::zone_set<T> &zs_in){
+    timedrel::closed_zone_set<T> zs_res;
+    for(const auto& z : zs_in){
         T cbmin = z.get_bmin().value;
         T cbmax = z.get_bmax().value;
         T cemin = z.get_emin().value;
         T cemax = z.get_emax().value;
         T cdmin = z.get_dmin().value;
         T cdmax = z.get_dmax().value;
-        zs_res.add({cbmin,cbmax,cemin,cemax,cdmin,cdmax},{1,1,1,1,1,1});
+        zs_res.add({cbmin,cbmax,cemin,cemax,cdmin,cdmax});
     }
     return zs_res;
 }
 
 /* Fully accurate (hopefully) */
 template <typename T>
-T get_time_robustness_translation_optimal(timedrel::zone_set<T> &zs_in, T l, T u, T scope_start, T scope_end){
+T get_time_robustness_translation_optimal(const timedrel::zone_set<T> &zs_in, T l, T u, T scope_start, T scope_end){
     T rob_value_right = 0, rob_value_left = 0, rob_value = 0;
-    auto zs_line = timedrel::zone_set<T>();
-    zs_line.add({scope_start,scope_end,scope_start,scope_end,u-l,u-l},{1,1,1,1,1,1});
+    auto zs_line = timedrel::closed_zone_set<T>();
+    zs_line.add({scope_start,scope_end,scope_start,scope_end,u-l,u-l});
     auto zs_in_closed = make_zone_set_boundaries_closed<T>(zs_in);
-    auto zs_inter = timedrel::zone_set<T>::intersection(zs_in_closed, zs_line);
+    auto zs_inter = timedrel::closed_zone_set<T>::intersection(zs_in_closed, zs_line);
 
     std::vector<T> border_points_right, border_points_left;
     std::vector<T> eborder_points_right, eborder_points_left;
     /* Get points to the right and points to the left */
-    for(auto z : zs_inter){
+    for(const auto& z : zs_inter){
         T sp = z.get_bmin().value;
         T ep = z.get_bmax().value;
         T esp = z.get_emin().value;
@@ -209,14 +237,14 @@ T get_time_robustness_translation_optimal(timedrel::zone_set<T> &zs_in, T l, T u
     while (i < border_points_right.size() and is_included){
         new_point = border_points_right[i];
         enew_point = eborder_points_right[i];
-        auto zs_segment = timedrel::zone_set<T>();
+        auto zs_segment = timedrel::closed_zone_set<T>();
         zs_segment.add({old_point, new_point,
             eold_point, enew_point,
-            u-l,u-l},{1,1,1,1,1,1});
+            u-l,u-l});
         old_point = new_point;
         eold_point = enew_point;
 
-        is_included = timedrel::zone_set<T>::includes(zs_inter, zs_segment);
+        is_included = timedrel::closed_zone_set<T>::includes(zs_inter, zs_segment);
         i++;
     } //while (i < border_points_right.size() and timedrel::zone_set<T>::includes(zs_inter, zs_segment));
     /* Assign robustness value to the right */
@@ -235,15 +263,15 @@ T get_time_robustness_translation_optimal(timedrel::zone_set<T> &zs_in, T l, T u
     while(i >= 0 and is_included){
         new_point = border_points_left[i];
         enew_point = eborder_points_left[i];
-        auto zs_segment = timedrel::zone_set<T>();
+        auto zs_segment = timedrel::closed_zone_set<T>();
         zs_segment.add({new_point, old_point,
             enew_point, eold_point,
-            u-l,u-l},{1,1,1,1,1,1});
+            u-l,u-l});
 
         old_point = new_point;
         eold_point = enew_point;
 
-        is_included = timedrel::zone_set<T>::includes(zs_inter, zs_segment);
+        is_included = timedrel::closed_zone_set<T>::includes(zs_inter, zs_segment);
         i--;
     } // while(i >= 0 and timedrel::zone_set<T>::includes(zs_inter, zs_segment));
     /* Assign robustness value to the left */
@@ -256,14 +284,45 @@ T get_time_robustness_translation_optimal(timedrel::zone_set<T> &zs_in, T l, T u
 }
 
 template <typename T>
-void print_zone_set(timedrel::zone_set<T> &zs_in){
+void print_zone_set(const timedrel::zone_set<T> &zs_in){
     std::cout<<"------"<<std::endl;
-    for(auto z : zs_in){
+    for(const auto& z : zs_in){
         std::cout<<z<<std::endl;
     }
     std::cout<<"------"<<std::endl;
 }
 
+/* Results of the bound operators, disabled until `cache_enable` */
+template <typename T>
+timedrel::operator_cache<T>& operator_results(){
+    static timedrel::operator_cache<T> cache;
+    return cache;
+}
+
+template <typename T>
+std::function<timedrel::zone_set<T>(const timedrel::zone_set<T>&)>
+cached_unary(const std::string& name, timedrel::zone_set<T> (*op)(const timedrel::zone_set<T>&)){
+    return [name, op](const timedrel::zone_set<T>& zs){
+        return operator_results<T>().apply(name, {&zs}, {}, [&]{ return op(zs); });
+    };
+}
+
+template <typename T>
+std::function<timedrel::zone_set<T>(const timedrel::zone_set<T>&, const timedrel::zone_set<T>&)>
+cached_binary(const std::string& name, timedrel::zone_set<T> (*op)(const timedrel::zone_set<T>&, const timedrel::zone_set<T>&)){
+    return [name, op](const timedrel::zone_set<T>& zs1, const timedrel::zone_set<T>& zs2){
+        return operator_results<T>().apply(name, {&zs1, &zs2}, {}, [&]{ return op(zs1, zs2); });
+    };
+}
+
+template <typename T>
+std::function<timedrel::zone_set<T>(const timedrel::zone_set<T>&, T, T)>
+cached_bounded(const std::string& name, timedrel::zone_set<T> (*op)(const timedrel::zone_set<T>&, T, T)){
+    return [name, op](const timedrel::zone_set<T>& zs, T a, T b){
+        return operator_results<T>().apply(name, {&zs}, {a, b}, [&]{ return op(zs, a, b); });
+    };
+}
+
 namespace py = pybind11;
 
 using T = double;
@@ -278,7 +337,9 @@ PYBIND11_MODULE(robustTRE, m) {
     typedef lower_bound<T> lower_bound_type;
     typedef upper_bound<T> upper_bound_type;
 
-    m.def("trmtrans", &time_robust_match_translation<T>);
+    m.def("trmtrans", [](const timedrel::zone_set<T>& zs, T r_lbound){
+        return operator_results<T>().apply("trmtrans", {&zs}, {r_lbound}, [&]{ return time_robust_match_translation<T>(zs, r_lbound); });
+    });
     m.def("zsetprint", &print_zone_set<T>);
     m.def("trobustness", &get_time_robustness_translation<T>);
     m.def("trobustness_opt", &get_time_robustness_translation_optimal<T>);
@@ -304,6 +365,16 @@ PYBIND11_MODULE(robustTRE, m) {
     typedef zone<T> zone_type;
     typedef zone_set<T> zone_set_type;
 
+    typedef py::array_t<T, py::array::c_style | py::array::forcecast> value_array;
+    typedef py::array_t<bool, py::array::c_style | py::array::forcecast> sign_array;
+
+    py::enum_<period_anchor>(m, "anchor")
+        .value("none", period_anchor::none)
+        .value("rise", period_anchor::rise)
+        .value("fall", period_anchor::fall)
+        .value("both", period_anchor::both)
+    ;
+
     py::class_<zone_type>(m, "zone")
         .def("bmin", &zone_type::get_bmin)
         .def("bmax", &zone_type::get_bmax)
@@ -329,37 +400,347 @@ PYBIND11_MODULE(robustTRE, m) {
         .def("add_from_period_fall_anchor", &zone_set_type::add_from_period_fall_anchor)
         .def("add_from_period_both_anchor", &zone_set_type::add_from_period_both_anchor)
         .def("empty", &zone_set_type::empty)
+        .def("__len__", &zone_set_type::size)
+        .def("build_block_index", &zone_set_type::build_block_index, py::arg("block_size") = 64)
+        .def("has_block_index", [](const zone_set_type& zs){ return zs.get_block_index() != nullptr; })
+        .def_static("from_arrays", [](const value_array& values, const py::object& signs, unsigned num_threads){
+            if(values.ndim() != 2 or values.shape(1) != 6){
+                throw py::value_error("from_arrays: values must have shape (n, 6)");
+            }
+            sign_array sign_values;
+            const bool* sign_ptr = nullptr;
+            if(!signs.is_none()){
+                sign_values = signs.cast<sign_array>();
+                if(sign_values.ndim() != 2 or sign_values.shape(0) != values.shape(0) or sign_values.shape(1) != 6){
+                    throw py::value_error("from_arrays: signs must have the same shape as values");
+                }
+                sign_ptr = sign_values.data();
+            }
+            py::gil_scoped_release release;
+            return zone_set_type::from_arrays(values.data(), sign_ptr, values.shape(0), num_threads);
+        }, py::arg("values"), py::arg("signs") = py::none(), py::arg("num_threads") = 1)
+        .def_static("from_periods", [](const value_array& begins, const value_array& ends, period_anchor anchor, unsigned num_threads){
+            if(begins.ndim() != 1 or ends.ndim() != 1 or begins.shape(0) != ends.shape(0)){
+                throw py::value_error("from_periods: begins and ends must be 1-d arrays of equal length");
+            }
+            py::gil_scoped_release release;
+            return zone_set_type::from_periods(begins.data(), ends.data(), begins.shape(0), anchor, num_threads);
+        }, py::arg("begins"), py::arg("ends"), py::arg("anchor") = period_anchor::none, py::arg("num_threads") = 1)
+        .def("save", [](const zone_set_type& zs, const std::string& path, std::size_t block_size){
+            py::gil_scoped_release release;
+            save(zs, path, block_size);
+        }, py::arg("path"), py::arg("block_size") = 64)
+        .def("statistics", &zone_set_statistics<T>::compute, py::arg("bins") = 16)
         .def("__iter__", [](const zone_set_type &s) { return py::make_iterator(s.cbegin(), s.cend()); },
                          py::keep_alive<0, 1>() /* Essential: keep object alive while iterator exists */)
     ;
 
-    m.def("filter", &zone_set_type::filter);
+    // Binary persistence
+    m.def("load", [](const std::string& path, bool use_mmap){
+        py::gil_scoped_release release;
+        return load<T>(path, use_mmap);
+    }, py::arg("path"), py::arg("mmap") = false);
+
+    py::class_<mapped_zone_set<T>>(m, "mapped_zone_set")
+        .def(py::init<const std::string&>())
+        .def("__len__", &mapped_zone_set<T>::size)
+        .def("__getitem__", &mapped_zone_set<T>::at)
+        .def("is_sorted_by_bmin", &mapped_zone_set<T>::is_sorted_by_bmin)
+        .def("slice", &mapped_zone_set<T>::slice)
+        .def("to_zone_set", &mapped_zone_set<T>::to_zone_set)
+    ;
+
+    // Out-of-core evaluation over segment files
+    py::class_<external_options>(m, "external_options")
+        .def(py::init<>())
+        .def_readwrite("directory", &external_options::directory)
+        .def_readwrite("prefix", &external_options::prefix)
+        .def_readwrite("memory_budget", &external_options::memory_budget)
+        .def_readwrite("block_size", &external_options::block_size)
+    ;
+
+    typedef std::vector<std::string> segments;
+
+    m.def("write_segments", [](const zone_set_type& zs, const external_options& options){
+        py::gil_scoped_release release;
+        return write_segments<T>(zs, options);
+    });
+    m.def("read_segments", [](const segments& paths){
+        py::gil_scoped_release release;
+        return read_segments<T>(paths);
+    });
+    m.def("remove_segments", &remove_segments);
+    m.def("external_sort", [](const segments& paths, const external_options& options){
+        py::gil_scoped_release release;
+        return external_sort<T>(paths, options);
+    });
+    m.def("external_filter", [](const segments& paths, const external_options& options){
+        py::gil_scoped_release release;
+        return external_filter<T>(paths, options);
+    });
+    m.def("external_intersection", [](const segments& paths1, const segments& paths2, const external_options& options){
+        py::gil_scoped_release release;
+        return external_intersection<T>(paths1, paths2, options);
+    });
+    m.def("external_concatenation", [](const segments& paths1, const segments& paths2, const external_options& options){
+        py::gil_scoped_release release;
+        return external_concatenation<T>(paths1, paths2, options);
+    });
+
+    // Incremental evaluation over append-only inputs
+    typedef online_monitor<T> online_monitor_type;
+
+    py::class_<online_monitor_type>(m, "online_monitor")
+        .def(py::init<>())
+        .def("atom", &online_monitor_type::atom, py::arg("anchor") = period_anchor::none)
+        .def("intersection", &online_monitor_type::intersection)
+        .def("union", &online_monitor_type::set_union)
+        .def("concatenation", &online_monitor_type::concatenation)
+        .def<std::size_t (online_monitor_type::*)(std::size_t, T, T)>("duration_restriction", &online_monitor_type::duration_restriction)
+        .def("set_output", &online_monitor_type::set_output)
+        .def("push_period", &online_monitor_type::push_period)
+        .def("advance", &online_monitor_type::advance)
+        .def("finish", &online_monitor_type::finish)
+        .def("watermark", &online_monitor_type::watermark)
+        .def("resident_zones", &online_monitor_type::resident_zones)
+    ;
+
+    typedef zone_set_statistics<T> statistics_type;
+
+    py::class_<statistics_type>(m, "statistics")
+        .def_readonly("count", &statistics_type::count)
+        .def_readonly("begin", &statistics_type::begin)
+        .def_readonly("end", &statistics_type::end)
+        .def_readonly("average_active", &statistics_type::average_active)
+        .def_readonly("min_duration", &statistics_type::min_duration)
+        .def_readonly("duration_bin_width", &statistics_type::duration_bin_width)
+        .def_readonly("duration_histogram", &statistics_type::duration_histogram)
+        .def("span", &statistics_type::span)
+    ;
+
+    // Compiled TRE query plans
+    typedef plan<T> plan_type;
+    static plan_cache<T> plans;
+
+    auto atom_pointers = [](const py::dict& atoms){
+        typename plan_type::atom_map pointers;
+        for(auto item : atoms){
+            pointers[item.first.cast<std::string>()] = item.second.cast<zone_set_type*>();
+        }
+        return pointers;
+    };
+
+    py::class_<plan_type, std::shared_ptr<plan_type>>(m, "plan")
+        .def("evaluate", [atom_pointers](const plan_type& self, const py::dict& atoms, unsigned num_threads){
+            auto pointers = atom_pointers(atoms);
+            py::gil_scoped_release release;
+            if(num_threads == 1 or self.outputs().size() != 1){
+                return self.evaluate(pointers);
+            }
+            return evaluate_parallel(self, pointers, num_threads).front();
+        }, py::arg("atoms"), py::arg("num_threads") = 1)
+        .def("evaluate_all", [atom_pointers](const plan_type& self, const py::dict& atoms, unsigned num_threads){
+            auto pointers = atom_pointers(atoms);
+            py::gil_scoped_release release;
+            if(num_threads == 1){
+                return self.evaluate_all(pointers);
+            }
+            return evaluate_parallel(self, pointers, num_threads);
+        }, py::arg("atoms"), py::arg("num_threads") = 1)
+        .def("optimize", [atom_pointers](const plan_type& self, const py::dict& atoms){
+            auto pointers = atom_pointers(atoms);
+            py::gil_scoped_release release;
+            return std::make_shared<plan_type>(optimize(self, pointers));
+        })
+        .def("atoms", &plan_type::atoms)
+        .def("__len__", &plan_type::size)
+        .def("__str__", &plan_type::toString)
+    ;
+
+    m.def("compile", [](const std::string& text){ return plans.get(text); });
+    m.def("compile_many", [](const std::vector<std::string>& texts){
+        return std::make_shared<plan_type>(compile_many<T>(texts));
+    });
+
+    // Atomic propositions from sampled signals
+    py::enum_<comparison>(m, "comparison")
+        .value("gt", comparison::gt)
+        .value("geq", comparison::geq)
+        .value("lt", comparison::lt)
+        .value("leq", comparison::leq)
+    ;
+
+    py::class_<predicate<T>>(m, "predicate")
+        .def(py::init<std::size_t, comparison, T, T, period_anchor>(),
+             py::arg("signal"), py::arg("op"), py::arg("threshold"),
+             py::arg("hysteresis") = 0.0, py::arg("anchor") = period_anchor::none)
+        .def_readwrite("signal", &predicate<T>::signal)
+        .def_readwrite("op", &predicate<T>::op)
+        .def_readwrite("threshold", &predicate<T>::threshold)
+        .def_readwrite("hysteresis", &predicate<T>::hysteresis)
+        .def_readwrite("anchor", &predicate<T>::anchor)
+    ;
+
+    m.def("ingest", [](const value_array& times, const py::list& signals, const std::vector<predicate<T>>& predicates, unsigned num_threads){
+        if(times.ndim() != 1){
+            throw py::value_error("ingest: times must be a 1-d array");
+        }
+        std::vector<value_array> arrays;
+        std::vector<const T*> pointers;
+        for(size_t k = 0; k < signals.size(); k++){
+            arrays.push_back(signals[k].cast<value_array>());
+            if(arrays.back().ndim() != 1 or arrays.back().shape(0) != times.shape(0)){
+                throw py::value_error("ingest: every signal must be a 1-d array as long as times");
+            }
+            pointers.push_back(arrays.back().data());
+        }
+        py::gil_scoped_release release;
+        return ingest_signals<T>(times.data(), pointers, times.shape(0), predicates, num_threads);
+    }, py::arg("times"), py::arg("signals"), py::arg("predicates"), py::arg("num_threads") = 1);
+
+    py::class_<period_coalescer<T>>(m, "period_coalescer")
+        .def(py::init<T, period_anchor>(), py::arg("gap_tolerance") = 0.0, py::arg("anchor") = period_anchor::none)
+        .def("add", &period_coalescer<T>::add)
+        .def("build", &period_coalescer<T>::build)
+        .def("saved", &period_coalescer<T>::saved)
+        .def("dropped", &period_coalescer<T>::dropped)
+        .def("clear", &period_coalescer<T>::clear)
+        .def("__len__", &period_coalescer<T>::size)
+    ;
+
+    // Batch evaluation over many traces
+    py::class_<trace_summary<T>>(m, "trace_summary")
+        .def_readonly("zones", &trace_summary<T>::zones)
+        .def_readonly("first_begin", &trace_summary<T>::first_begin)
+        .def_readonly("last_end", &trace_summary<T>::last_end)
+        .def_readonly("robustness", &trace_summary<T>::robustness)
+        .def("matched", &trace_summary<T>::matched)
+    ;
+
+    py::class_<batch_result<T>>(m, "batch_result")
+        .def_readonly("matches", &batch_result<T>::matches)
+        .def_readonly("summaries", &batch_result<T>::summaries)
+    ;
+
+    m.def("translation_robustness", &translation_robustness<T>);
+
+    m.def("evaluate_batch", [atom_pointers](const plan_type& p, const py::list& traces, unsigned num_threads, bool keep_matches){
+        std::vector<typename plan_type::atom_map> maps;
+        for(size_t i = 0; i < traces.size(); i++){
+            maps.push_back(atom_pointers(traces[i].cast<py::dict>()));
+        }
+        py::gil_scoped_release release;
+        return evaluate_batch(p, maps, num_threads, keep_matches);
+    }, py::arg("plan"), py::arg("traces"), py::arg("num_threads") = 0, py::arg("keep_matches") = true);
+
+    m.def("evaluate_batch_signals", [](const plan_type& p, const py::list& times, const py::list& signals,
+                                       const std::map<std::string, predicate<T>>& atoms, unsigned num_threads, bool keep_matches){
+        if(times.size() != signals.size()){
+            throw py::value_error("evaluate_batch_signals: times and signals must have one entry per trace");
+        }
+        std::vector<value_array> arrays;
+        std::vector<signal_trace<T>> traces;
+        for(size_t i = 0; i < times.size(); i++){
+            arrays.push_back(times[i].cast<value_array>());
+            if(arrays.back().ndim() != 1){
+                throw py::value_error("evaluate_batch_signals: times must be 1-d arrays");
+            }
+            signal_trace<T> trace{arrays.back().data(), std::vector<const T*>(), static_cast<std::size_t>(arrays.back().shape(0))};
+            py::list columns = signals[i].cast<py::list>();
+            for(size_t k = 0; k < columns.size(); k++){
+                arrays.push_back(columns[k].cast<value_array>());
+                if(arrays.back().ndim() != 1 or static_cast<std::size_t>(arrays.back().shape(0)) != trace.samples){
+                    throw py::value_error("evaluate_batch_signals: every signal must be a 1-d array as long as its times");
+                }
+                trace.signals.push_back(arrays.back().data());
+            }
+            traces.push_back(trace);
+        }
+        py::gil_scoped_release release;
+        return evaluate_batch(p, traces, atoms, num_threads, keep_matches);
+    }, py::arg("plan"), py::arg("times"), py::arg("signals"), py::arg("atoms"),
+       py::arg("num_threads") = 0, py::arg("keep_matches") = true);
+
+    // Memoization of operator results
+    py::class_<operator_cache_stats>(m, "cache_stats")
+        .def_readonly("hits", &operator_cache_stats::hits)
+        .def_readonly("misses", &operator_cache_stats::misses)
+        .def_readonly("collisions", &operator_cache_stats::collisions)
+        .def_readonly("evictions", &operator_cache_stats::evictions)
+        .def_readonly("entries", &operator_cache_stats::entries)
+        .def_readonly("capacity", &operator_cache_stats::capacity)
+    ;
+    m.def("cache_enable", [](std::size_t capacity){ operator_results<T>().set_capacity(capacity); }, py::arg("capacity") = 128);
+    m.def("cache_disable", []{ operator_results<T>().set_capacity(0); });
+    m.def("cache_clear", []{ operator_results<T>().clear(); });
+    m.def("cache_stats", []{ return operator_results<T>().stats(); });
+
+    // Duplicate counts of zone interning
+    py::class_<zone_interner_stats>(m, "intern_stats")
+        .def_readonly("lookups", &zone_interner_stats::lookups)
+        .def_readonly("duplicates", &zone_interner_stats::duplicates)
+        .def_readonly("entries", &zone_interner_stats::entries)
+        .def_property_readonly("duplicate_rate", &zone_interner_stats::duplicate_rate)
+    ;
+
+    m.def("filter", cached_unary<T>("filter", &zone_set_type::filter));
     m.def("includes", &zone_set_type::includes);
+    m.def("first_uncovered", [](const zone_set_type& zs1, const zone_set_type& zs2) -> py::object {
+        auto it = zone_set_type::first_uncovered(zs1, zs2);
+        if(it == zs2.cend()){
+            return py::none();
+        }
+        return py::cast(*it);
+    });
+    m.def("filter_ranked", cached_unary<T>("filter_ranked", &filter_ranked<T>));
+    m.def("includes_ranked", &includes_ranked<T>);
+    m.def("filter_parallel", [](const zone_set_type& zs, unsigned num_threads){
+        py::gil_scoped_release release;
+        return zone_set_type::filter_parallel(zs, num_threads);
+    }, py::arg("zs"), py::arg("num_threads") = 0);
 
     // Set operations
-    m.def<zone_set_type (*)(const zone_set_type&)>("complementation", &zone_set_type::complementation);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("duration_restriction", &zone_set_type::duration_restriction);
-    m.def<zone_set_type (*)(const zone_set_type&, const zone_set_type&)>("union", &zone_set_type::set_union);
-    m.def<zone_set_type (*)(const zone_set_type&, const zone_set_type&)>("intersection", &zone_set_type::intersection);
-    m.def<zone_set_type (*)(const zone_set_type&, const zone_set_type&)>("difference", &zone_set_type::set_difference);
+    m.def("complementation", cached_unary<T>("complementation", &zone_set_type::complementation));
+    m.def("duration_restriction", cached_bounded<T>("duration_restriction", &zone_set_type::duration_restriction));
+    m.def("union", cached_binary<T>("union", &zone_set_type::set_union));
+    m.def("intersection", cached_binary<T>("intersection", &zone_set_type::intersection));
+    m.def("intersection_parallel", [](const zone_set_type& zs1, const zone_set_type& zs2, unsigned num_threads){
+        py::gil_scoped_release release;
+        return zone_set_type::intersection_parallel(zs1, zs2, num_threads);
+    }, py::arg("zs1"), py::arg("zs2"), py::arg("num_threads") = 0);
+    m.def("difference", cached_binary<T>("difference", &zone_set_type::set_difference));
 
     // Sequential operations
-    m.def<zone_set_type (*)(const zone_set_type&, const zone_set_type&)>("concatenation", &zone_set_type::concatenation);
-    m.def<zone_set_type (*)(const zone_set_type&)>("transitive_closure", &zone_set_type::transitive_closure);
+    m.def("concatenation", cached_binary<T>("concatenation", &zone_set_type::concatenation));
+    m.def("concatenation_parallel", [](const zone_set_type& zs1, const zone_set_type& zs2, unsigned num_threads){
+        py::gil_scoped_release release;
+        return zone_set_type::concatenation_parallel(zs1, zs2, num_threads);
+    }, py::arg("zs1"), py::arg("zs2"), py::arg("num_threads") = 0);
+    m.def("transitive_closure", cached_unary<T>("transitive_closure", &zone_set_type::transitive_closure));
+    m.def("transitive_closure_stats", [](const zone_set_type& zs){
+        zone_interner<zone_type> table;
+        zone_set_type result = zone_set_type::transitive_closure(zs, table);
+        return std::make_pair(result, table.stats());
+    });
+    m.def("concatenation_duration_restriction", [](const zone_set_type& zs1, const zone_set_type& zs2, T a, T b){
+        return operator_results<T>().apply("concatenation_duration_restriction", {&zs1, &zs2}, {a, b}, [&]{
+            return zone_set_type::concatenation_duration_restriction(zs1, zs2, a, b);
+        });
+    });
 
     // Modal operations of the logic of time periods
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("diamond_starts", &zone_set_type::diamond_starts);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("diamond_started_by", &zone_set_type::diamond_started_by);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("diamond_finishes", &zone_set_type::diamond_finishes);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("diamond_finished_by", &zone_set_type::diamond_finished_by);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("diamond_meets", &zone_set_type::diamond_meets);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("diamond_met_by", &zone_set_type::diamond_met_by);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("box_starts", &zone_set_type::box_starts);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("box_started_by", &zone_set_type::box_started_by);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("box_finishes", &zone_set_type::box_finishes);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("box_finished_by", &zone_set_type::box_finished_by);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("box_meets", &zone_set_type::box_meets);
-    m.def<zone_set_type (*)(const zone_set_type&, T, T)>("box_met_by", &zone_set_type::box_met_by);
+    m.def("diamond_starts", cached_bounded<T>("diamond_starts", &zone_set_type::diamond_starts));
+    m.def("diamond_started_by", cached_bounded<T>("diamond_started_by", &zone_set_type::diamond_started_by));
+    m.def("diamond_finishes", cached_bounded<T>("diamond_finishes", &zone_set_type::diamond_finishes));
+    m.def("diamond_finished_by", cached_bounded<T>("diamond_finished_by", &zone_set_type::diamond_finished_by));
+    m.def("diamond_meets", cached_bounded<T>("diamond_meets", &zone_set_type::diamond_meets));
+    m.def("diamond_met_by", cached_bounded<T>("diamond_met_by", &zone_set_type::diamond_met_by));
+    m.def("box_starts", cached_bounded<T>("box_starts", &zone_set_type::box_starts));
+    m.def("box_started_by", cached_bounded<T>("box_started_by", &zone_set_type::box_started_by));
+    m.def("box_finishes", cached_bounded<T>("box_finishes", &zone_set_type::box_finishes));
+    m.def("box_finished_by", cached_bounded<T>("box_finished_by", &zone_set_type::box_finished_by));
+    m.def("box_meets", cached_bounded<T>("box_meets", &zone_set_type::box_meets));
+    m.def("box_met_by", cached_bounded<T>("box_met_by", &zone_set_type::box_met_by));
 
 #ifdef VERSION_INFO
     m.attr("__version__") = VERSION_INFO;
@@ -54,7 +54,8 @@ robusttre_module = Extension(
     language = 'c++',
     libraries=libraries,
     library_dirs=['/usr/lib', '/usr/lib/x86_64-linux-gnu'],
-    extra_link_args=['-std=c++11', '-lppl', '-lgmp', '-lgmpxx'],
+    extra_compile_args=['-pthread'],
+    extra_link_args=['-std=c++11', '-pthread', '-lppl', '-lgmp', '-lgmpxx'],
 )
 # '-stdlib=libc++',
 
@@ -67,7 +68,8 @@ setup(
     license='GPLv3+',
     python_requires='>=3',
     install_requires=[#'antlr4-python3-runtime==4.7.1',
-                      'pybind11>=2.11'],
+                      'pybind11>=2.11',
+                      'numpy'],
     #ext_package='robusttre',
     # ext_modules=[ext_instance_int, ext_instance_float, ext_instance_rational, ext_instance_diag, ext_instance_robust]
     ext_modules=[robusttre_module]